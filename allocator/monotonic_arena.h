@@ -0,0 +1,224 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A monotonic arena and a C++ 11 allocator for containers to allocate
+//      from it.
+//      Allocation is a pointer bump and deallocation is a no-op. Memory is
+//      released in bulk by rewinding the arena, and reused after that, so
+//      the same memory stays hot in the cache.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace utils
+{
+
+/*
+Notes:
+1.  Memory is held in chunks. Chunks are never freed until the arena is
+    destroyed, so after warm-up an arena allocates nothing from the heap.
+2.  mark() and rewind() release everything allocated after the mark.
+    Marks must be rewound in the reverse order they were taken.
+3.  The arena is not thread safe. It is meant to be used by one thread,
+    say as the scratch arena of a thread_pool worker.
+4.  Destructors of objects allocated from the arena are not run on rewind.
+    Use it for containers that are destroyed before the rewind.
+*/
+
+class monotonic_arena
+{
+public:
+    // position in the arena to rewind to.
+    struct marker
+    {
+        size_t chunk_;
+        char * pos_;
+    };
+
+    //
+    // Param: chunk_size - size of each chunk allocated from the heap.
+    //          Larger allocations get a chunk of their own size.
+    //
+    explicit monotonic_arena(size_t chunk_size = 64 * 1024) noexcept :
+        chunk_size_{chunk_size}, current_{0}, pos_{nullptr}, end_{nullptr}
+    {
+    }
+
+    ~monotonic_arena()
+    {
+        for (auto & c : chunks_)
+        {
+            free(c.begin_);
+        }
+    }
+
+    void * allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        auto p = align_up(pos_, alignment);
+        if (pos_ && p + bytes <= end_)
+        {
+            pos_ = p + bytes;
+            return p;
+        }
+        return allocate_slow(bytes, alignment);
+    }
+
+    marker mark() const
+    {
+        return marker{current_, pos_};
+    }
+
+    void rewind(const marker & m)
+    {
+        current_ = m.chunk_;
+        pos_ = m.pos_;
+        end_ = pos_ ? chunks_[current_].end_ : nullptr;
+    }
+
+    // release everything allocated.
+    void reset()
+    {
+        rewind(marker{0, nullptr});
+    }
+
+    // bytes held from the heap.
+    size_t capacity() const
+    {
+        size_t n = 0;
+        for (auto & c : chunks_)
+        {
+            n += size_t(c.end_ - c.begin_);
+        }
+        return n;
+    }
+
+    // No copy construction or assignment.
+    monotonic_arena(const monotonic_arena &) = delete;
+    monotonic_arena & operator=(const monotonic_arena &) = delete;
+
+private:
+    struct chunk
+    {
+        char * begin_;
+        char * end_;
+    };
+
+    static char * align_up(char * p, size_t alignment)
+    {
+        auto u = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char *>((u + alignment - 1) & ~(alignment - 1));
+    }
+
+    void * allocate_slow(size_t bytes, size_t alignment)
+    {
+        auto need = bytes + alignment - 1;
+
+        // reuse the next chunk that fits, from an earlier rewind.
+        auto next = pos_ ? current_ + 1 : 0;
+        while (
+            next < chunks_.size()
+            && size_t(chunks_[next].end_ - chunks_[next].begin_) < need
+        )
+        {
+            ++next;
+        }
+
+        if (next == chunks_.size())
+        {
+            auto size = std::max(chunk_size_, need);
+            auto p = static_cast<char *>(malloc(size));
+            if (!p)
+            {
+                throw std::bad_alloc{};
+            }
+            chunks_.push_back(chunk{p, p + size});
+        }
+
+        current_ = next;
+        end_ = chunks_[current_].end_;
+        auto p = align_up(chunks_[current_].begin_, alignment);
+        pos_ = p + bytes;
+        return p;
+    }
+
+    size_t chunk_size_;
+    std::vector<chunk> chunks_;
+
+    // chunk allocating from, and the free range in it.
+    size_t current_;
+    char * pos_;
+    char * end_;
+};
+
+//
+// Allocator for std containers to allocate from a monotonic_arena.
+//
+template<typename T>
+class arena_allocator
+{
+public:
+    using value_type = T;
+    using pointer = T * ;
+    using reference = T & ;
+    using const_pointer = const T*;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    explicit arena_allocator(monotonic_arena & arena) noexcept :
+        arena_{&arena}
+    {
+    }
+
+    template <class U>
+    arena_allocator(const arena_allocator<U> & other) noexcept :
+        arena_{other.arena_}
+    {
+    }
+
+    template <typename Type>
+    struct rebind
+    {
+        using other = arena_allocator<Type>;
+    };
+
+    pointer allocate(size_type n)
+    {
+        return static_cast<pointer>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(pointer, size_type)
+    {
+        // released in bulk by rewind of the arena.
+    }
+
+    template <class U>
+    bool operator == (const arena_allocator<U> & other) const noexcept
+    {
+        return arena_ == other.arena_;
+    }
+
+    template <class U>
+    bool operator != (const arena_allocator<U> & other) const noexcept
+    {
+        return arena_ != other.arena_;
+    }
+
+private:
+    monotonic_arena * arena_;
+
+    template <class U> friend class arena_allocator;
+};
+
+} // namespace utils
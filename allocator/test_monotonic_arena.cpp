@@ -0,0 +1,87 @@
+#include "monotonic_arena.h"
+#include "../test/test.h"
+
+using namespace utils;
+
+using std::cout;
+#include <map>
+using std::map;
+#include <vector>
+using std::vector;
+
+void test_allocate()
+{
+    monotonic_arena arena(1024);
+    auto p1 = static_cast<char *>(arena.allocate(10, 1));
+    auto p2 = static_cast<char *>(arena.allocate(10, 1));
+    ASSERT_M(p2 == p1 + 10, "arena allocation is a pointer bump");
+
+    auto p3 = arena.allocate(8, 64);
+    ASSERT_M(reinterpret_cast<uintptr_t>(p3) % 64 == 0, "arena alignment");
+
+    auto big = arena.allocate(4096, 8);
+    ASSERT_M(big != nullptr && arena.capacity() >= 1024 + 4096,
+        "arena allocation larger than chunk size");
+}
+
+void test_rewind()
+{
+    monotonic_arena arena(1024);
+    auto p1 = arena.allocate(100);
+    auto m = arena.mark();
+    auto p2 = arena.allocate(100);
+    arena.allocate(2000);
+    arena.rewind(m);
+    auto p3 = arena.allocate(100);
+    ASSERT_M(p3 == p2, "arena rewind to mark");
+
+    auto capacity = arena.capacity();
+    arena.reset();
+    ASSERT_M(arena.allocate(100) == p1, "arena reset");
+    arena.allocate(2000);
+    ASSERT_M(arena.capacity() == capacity, "arena reuses chunks after reset");
+}
+
+void test_stdcontainers()
+{
+    monotonic_arena arena;
+    {
+        vector<int, arena_allocator<int>> v{arena_allocator<int>{arena}};
+        for (int i=0; i<1000; ++i)
+        {
+            v.push_back(i);
+        }
+        ASSERT_M(v.size() == 1000 && v[999] == 999, "arena std::vector");
+
+        map<
+            int, int, std::less<int>,
+            arena_allocator<std::pair<const int, int>>
+        > m{arena_allocator<std::pair<const int, int>>{arena}};
+        for (int i=0; i<100; ++i)
+        {
+            m[i] = i * i;
+        }
+        ASSERT_M(m.size() == 100 && m[9] == 81, "arena std::map");
+    }
+    auto capacity = arena.capacity();
+    arena.reset();
+    {
+        vector<int, arena_allocator<int>> v{arena_allocator<int>{arena}};
+        for (int i=0; i<1000; ++i)
+        {
+            v.push_back(i);
+        }
+    }
+    ASSERT_M(arena.capacity() == capacity, "arena no heap allocation after warm-up");
+}
+
+int main()
+{
+    test_allocate();
+    test_rewind();
+    test_stdcontainers();
+
+    cout << "\n done";
+    //getchar();
+    return 0;
+}
@@ -0,0 +1,212 @@
+//----------------------------------------------------------------------------
+// Benchmark of cache get latency for hits and misses with each index,
+// against the std::list + std::unordered_map layout cache had before, and
+// of multi_get in batches of 100 keys.
+// Build with optimization, say
+//      g++ -std=c++11 -O2 bench_cache_index.cpp -o bench_cache_index
+// Usage: bench_cache_index [capacity]
+//----------------------------------------------------------------------------
+
+#include "cache.h"
+using namespace utils;
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+using std::cout;
+#include <list>
+#include <string>
+using std::string;
+#include <unordered_map>
+#include <vector>
+
+// The cache layout before the flat slot array, kept here as the baseline.
+template<typename KEY, typename VAL>
+class list_map_cache
+{
+public:
+    list_map_cache(size_t capacity) : _capacity(capacity)
+    {
+    }
+
+    bool get(const KEY & key, VAL & val)
+    {
+        auto itr = _lookup.find(key);
+        if (itr == _lookup.end())
+        {
+            return false;
+        }
+        val = itr->second._val;
+        auto end_splice = itr->second._itr_lru; ++end_splice;
+        _lru.splice( _lru.end(), _lru, itr->second._itr_lru, end_splice);
+        return true;
+    }
+
+    void put(const KEY & key, const VAL & val)
+    {
+        auto itr = _lookup.find(key);
+        if (itr == _lookup.end())
+        {
+            if (_lookup.size() >= _capacity)
+            {
+                _lookup.erase(*_lru.begin());
+                _lru.pop_front();
+            }
+            _lookup.emplace(key, value_type{val, _lru.insert(_lru.end(), key)});
+        }
+        else
+        {
+            itr->second._val = val;
+        }
+    }
+
+private:
+    using list_type = std::list<KEY>;
+    struct value_type{
+        VAL _val;
+        typename list_type::iterator _itr_lru;
+    };
+
+    size_t _capacity;
+    std::unordered_map<KEY, value_type> _lookup;
+    list_type _lru;
+};
+
+uint64_t next_random(uint64_t & state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+template<typename KEY>
+KEY make_key(uint64_t i);
+
+template<>
+uint64_t make_key<uint64_t>(uint64_t i)
+{
+    return i;
+}
+
+template<>
+string make_key<string>(uint64_t i)
+{
+    return "http://example.com/page/" + std::to_string(i);
+}
+
+// Return: nanoseconds per get.
+template<typename CACHE, typename KEY>
+double time_gets(CACHE & c, const std::vector<KEY> & keys)
+{
+    uint64_t val = 0;
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto & key : keys)
+    {
+        found += c.get(key, val);
+    }
+    auto end = std::chrono::steady_clock::now();
+    // keep the loop from being optimized away.
+    if (found == size_t(-1))
+    {
+        cout << val;
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count()
+        / keys.size();
+}
+
+// Return: nanoseconds per key of multi_get in batches of 100 keys.
+template<typename CACHE, typename KEY>
+double time_multi_gets(CACHE & c, const std::vector<KEY> & keys)
+{
+    const size_t batch = 100;
+    std::vector<const uint64_t *> vals(batch);
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i=0; i+batch<=keys.size(); i+=batch)
+    {
+        found += c.multi_get(keys.begin() + i, keys.begin() + i + batch, vals.data());
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (found == size_t(-1))
+    {
+        cout << vals[0];
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count()
+        / keys.size();
+}
+
+template<typename CACHE, typename KEY>
+void bench_batch(const char * name, size_t capacity)
+{
+    CACHE c(capacity);
+    for (uint64_t i=0; i<capacity; ++i)
+    {
+        c.put(make_key<KEY>(i), i);
+    }
+    uint64_t state = 88172645463325252ull;
+    std::vector<KEY> hits, misses;
+    for (size_t i=0; i<1000000; ++i)
+    {
+        hits.push_back(make_key<KEY>(next_random(state) % capacity));
+        misses.push_back(make_key<KEY>(capacity + next_random(state) % capacity));
+    }
+
+    auto hit_ns = time_multi_gets(c, hits);
+    auto miss_ns = time_multi_gets(c, misses);
+    cout << "\n" << std::left << std::setw(36) << name
+        << std::right << std::fixed << std::setprecision(1)
+        << " hit " << std::setw(7) << hit_ns << " ns"
+        << "   miss " << std::setw(7) << miss_ns << " ns";
+}
+
+template<typename CACHE, typename KEY>
+void bench(const char * name, size_t capacity)
+{
+    CACHE c(capacity);
+    for (uint64_t i=0; i<capacity; ++i)
+    {
+        c.put(make_key<KEY>(i), i);
+    }
+
+    // random order so that each get is a cache miss in the cpu caches,
+    // as it is in a large cache under real traffic.
+    uint64_t state = 88172645463325252ull;
+    std::vector<KEY> hits, misses;
+    for (size_t i=0; i<1000000; ++i)
+    {
+        hits.push_back(make_key<KEY>(next_random(state) % capacity));
+        misses.push_back(make_key<KEY>(capacity + next_random(state) % capacity));
+    }
+
+    auto hit_ns = time_gets(c, hits);
+    auto miss_ns = time_gets(c, misses);
+    cout << "\n" << std::left << std::setw(36) << name
+        << std::right << std::fixed << std::setprecision(1)
+        << " hit " << std::setw(7) << hit_ns << " ns"
+        << "   miss " << std::setw(7) << miss_ns << " ns";
+}
+
+template<typename KEY>
+void bench_all(const char * key_name, size_t capacity)
+{
+    cout << "\n\nkey " << key_name << ", capacity " << capacity;
+    bench<list_map_cache<KEY, uint64_t>, KEY>("list + unordered_map", capacity);
+    bench<cache<KEY, uint64_t, lru_policy, flat_index>, KEY>("slot array + flat_index", capacity);
+    bench<cache<KEY, uint64_t, lru_policy, swiss_index>, KEY>("slot array + swiss_index", capacity);
+    bench_batch<cache<KEY, uint64_t, lru_policy, flat_index>, KEY>("flat_index multi_get", capacity);
+    bench_batch<cache<KEY, uint64_t, lru_policy, swiss_index>, KEY>("swiss_index multi_get", capacity);
+}
+
+int main(int argc, char ** argv)
+{
+    size_t capacity = (argc > 1) ? size_t(atol(argv[1])) : 1000000;
+    bench_all<uint64_t>("uint64_t", capacity);
+    bench_all<string>("string", capacity);
+    bench_all<uint64_t>("uint64_t", 10000);
+
+    cout << "\n done\n";
+    return 0;
+}
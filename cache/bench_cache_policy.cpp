@@ -0,0 +1,388 @@
+//----------------------------------------------------------------------------
+// Benchmark of cache policies and capacities by replaying key access
+// traces. Each access is a get, and a put of the key on a miss. Reports the
+// hit ratio, the throughput, and the p50 and p99 latency of an access.
+// Build with optimization, say
+//      g++ -std=c++11 -O2 bench_cache_policy.cpp -o bench_cache_policy
+// Usage: bench_cache_policy [options]
+//      --trace FILE        replay a trace file instead of generating one.
+//      --binary            the trace file is binary, else text.
+//      --write FILE        write the trace to FILE and exit.
+//      --gen NAME          synthetic trace when there is no --trace,
+//                          zipf (default), scan or loop.
+//      --keys N            number of distinct keys to generate (1000000).
+//      --ops N             number of accesses to generate (2000000).
+//      --skew S            zipf exponent (0.99).
+//      --capacity C,C,..   cache capacities (10000,100000).
+//      --policy P,P,..     lru, clock, slru, 2q, arc, lfu, tinylfu or all.
+// Trace formats:
+//      text    one unsigned 64 bit key per line, in decimal.
+//      binary  unsigned 64 bit keys, little endian, back to back.
+// Synthetic traces:
+//      zipf    keys drawn from a zipf distribution; a few keys are hot.
+//      scan    zipf, with a burst of never seen keys every 10000
+//              accesses, as 20% of the accesses; rewards scan resistance.
+//      loop    the keys in order, over and over; the worst case for lru
+//              when the cache is smaller than the loop.
+//----------------------------------------------------------------------------
+
+#include "cache.h"
+#include "tinylfu_policy.h"
+using namespace utils;
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+using std::cout;
+#include <random>
+#include <sstream>
+#include <string>
+using std::string;
+#include <vector>
+
+using trace = std::vector<uint64_t>;
+
+std::vector<string> split(const string & list)
+{
+    std::vector<string> items;
+    std::istringstream iss(list);
+    string item;
+    while (std::getline(iss, item, ','))
+    {
+        items.push_back(item);
+    }
+    return items;
+}
+
+bool read_trace(const string & path, bool binary, trace & keys)
+{
+    std::ifstream in(path, binary ? std::ios::binary : std::ios::in);
+    if (!in)
+    {
+        return false;
+    }
+    if (binary)
+    {
+        uint8_t bytes[8];
+        while (in.read(reinterpret_cast<char *>(bytes), sizeof(bytes)))
+        {
+            uint64_t key = 0;
+            for (int i=7; i>=0; --i)
+            {
+                key = (key << 8) | bytes[i];
+            }
+            keys.push_back(key);
+        }
+    }
+    else
+    {
+        uint64_t key;
+        while (in >> key)
+        {
+            keys.push_back(key);
+        }
+    }
+    return true;
+}
+
+bool write_trace(const string & path, bool binary, const trace & keys)
+{
+    std::ofstream out(path, binary ? std::ios::binary : std::ios::out);
+    for (auto key : keys)
+    {
+        if (binary)
+        {
+            uint8_t bytes[8];
+            for (int i=0; i<8; ++i)
+            {
+                bytes[i] = uint8_t(key >> (8 * i));
+            }
+            out.write(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+        }
+        else
+        {
+            out << key << '\n';
+        }
+    }
+    return bool(out);
+}
+
+// Draws ranks 0..n-1 with probability proportional to 1 / (rank + 1)^skew.
+class zipf
+{
+public:
+    zipf(size_t n, double skew)
+    {
+        _cdf.reserve(n);
+        double sum = 0;
+        for (size_t i=0; i<n; ++i)
+        {
+            sum += 1.0 / std::pow(double(i + 1), skew);
+            _cdf.push_back(sum);
+        }
+        for (auto & c : _cdf)
+        {
+            c /= sum;
+        }
+    }
+
+    template<typename RNG>
+    uint64_t operator()(RNG & rng)
+    {
+        auto u = std::uniform_real_distribution<double>(0, 1)(rng);
+        auto i = std::lower_bound(_cdf.begin(), _cdf.end(), u) - _cdf.begin();
+        return uint64_t(std::min(size_t(i), _cdf.size() - 1));
+    }
+
+private:
+    std::vector<double> _cdf;
+};
+
+// Return: the rank scattered over 64 bits, so hot keys are not adjacent.
+uint64_t scatter(uint64_t rank)
+{
+    rank *= 0x9E3779B97F4A7C15ull;
+    return rank ^ (rank >> 31);
+}
+
+bool generate(const string & name, size_t keys, size_t ops, double skew, trace & out)
+{
+    std::mt19937_64 rng(42);
+    out.reserve(ops);
+    if (name == "zipf")
+    {
+        zipf z(keys, skew);
+        while (out.size() < ops)
+        {
+            out.push_back(scatter(z(rng)));
+        }
+    }
+    else if (name == "scan")
+    {
+        zipf z(keys, skew);
+        uint64_t next_scan = keys;
+        while (out.size() < ops)
+        {
+            for (int i=0; i<8000 && out.size() < ops; ++i)
+            {
+                out.push_back(scatter(z(rng)));
+            }
+            for (int i=0; i<2000 && out.size() < ops; ++i)
+            {
+                out.push_back(scatter(next_scan++));
+            }
+        }
+    }
+    else if (name == "loop")
+    {
+        while (out.size() < ops)
+        {
+            out.push_back(scatter(out.size() % keys));
+        }
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+struct result
+{
+    double hit_ratio;
+    double mops;
+    double p50_ns;
+    double p99_ns;
+};
+
+template<typename POLICY>
+result replay(const trace & keys, size_t capacity)
+{
+    using clock = std::chrono::steady_clock;
+    result r;
+
+    // throughput and hit ratio, without timing each access.
+    {
+        utils::cache<uint64_t, uint64_t, POLICY> c(capacity);
+        size_t hits = 0;
+        auto start = clock::now();
+        for (auto key : keys)
+        {
+            if (c.get(key))
+            {
+                ++hits;
+            }
+            else
+            {
+                c.put(key, key);
+            }
+        }
+        auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+        r.hit_ratio = double(hits) / keys.size();
+        r.mops = keys.size() / seconds / 1e6;
+    }
+
+    // latency of each access, in a second run.
+    {
+        utils::cache<uint64_t, uint64_t, POLICY> c(capacity);
+        std::vector<float> ns;
+        ns.reserve(keys.size());
+        for (auto key : keys)
+        {
+            auto start = clock::now();
+            if (!c.get(key))
+            {
+                c.put(key, key);
+            }
+            ns.push_back(
+                float(std::chrono::duration<double, std::nano>(clock::now() - start).count())
+            );
+        }
+        auto p50 = ns.begin() + ns.size() / 2;
+        std::nth_element(ns.begin(), p50, ns.end());
+        r.p50_ns = *p50;
+        auto p99 = ns.begin() + ns.size() * 99 / 100;
+        std::nth_element(ns.begin(), p99, ns.end());
+        r.p99_ns = *p99;
+    }
+    return r;
+}
+
+bool run(const string & policy, const trace & keys, size_t capacity, result & r)
+{
+    if (policy == "lru")
+    {
+        r = replay<lru_policy>(keys, capacity);
+    }
+    else if (policy == "clock")
+    {
+        r = replay<clock_policy>(keys, capacity);
+    }
+    else if (policy == "slru")
+    {
+        r = replay<slru_policy>(keys, capacity);
+    }
+    else if (policy == "2q")
+    {
+        r = replay<two_q_policy>(keys, capacity);
+    }
+    else if (policy == "arc")
+    {
+        r = replay<arc_policy>(keys, capacity);
+    }
+    else if (policy == "lfu")
+    {
+        r = replay<lfu_policy>(keys, capacity);
+    }
+    else if (policy == "tinylfu")
+    {
+        r = replay<tinylfu_policy>(keys, capacity);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    string trace_path, write_path, gen = "zipf";
+    bool binary = false;
+    size_t num_keys = 1000000, ops = 2000000;
+    double skew = 0.99;
+    string capacities = "10000,100000";
+    string policies = "all";
+    for (int i=1; i<argc; ++i)
+    {
+        string arg = argv[i];
+        string value = (i + 1 < argc) ? argv[i + 1] : "";
+        if (arg == "--binary")
+        {
+            binary = true;
+            continue;
+        }
+        if (value.empty())
+        {
+            std::cerr << "missing value of " << arg << "\n";
+            return 1;
+        }
+        ++i;
+        if (arg == "--trace") trace_path = value;
+        else if (arg == "--write") write_path = value;
+        else if (arg == "--gen") gen = value;
+        else if (arg == "--keys") num_keys = size_t(std::atoll(value.c_str()));
+        else if (arg == "--ops") ops = size_t(std::atoll(value.c_str()));
+        else if (arg == "--skew") skew = std::atof(value.c_str());
+        else if (arg == "--capacity") capacities = value;
+        else if (arg == "--policy") policies = value;
+        else
+        {
+            std::cerr << "unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+
+    trace keys;
+    string source;
+    if (!trace_path.empty())
+    {
+        if (!read_trace(trace_path, binary, keys))
+        {
+            std::cerr << "cannot read " << trace_path << "\n";
+            return 1;
+        }
+        source = trace_path;
+    }
+    else
+    {
+        if (!generate(gen, std::max(num_keys, size_t(1)), ops, skew, keys))
+        {
+            std::cerr << "unknown generator " << gen << "\n";
+            return 1;
+        }
+        source = gen;
+    }
+    if (!write_path.empty())
+    {
+        return write_trace(write_path, binary, keys) ? 0 : 1;
+    }
+    if (keys.empty())
+    {
+        std::cerr << "empty trace\n";
+        return 1;
+    }
+
+    if (policies == "all")
+    {
+        policies = "lru,clock,slru,2q,arc,lfu,tinylfu";
+    }
+    cout << "trace " << source << ", " << keys.size() << " accesses";
+    for (const auto & cap : split(capacities))
+    {
+        auto capacity = size_t(std::atoll(cap.c_str()));
+        cout << "\n\ncapacity " << capacity
+            << "\npolicy     hit ratio    Mops/s    p50 ns    p99 ns";
+        for (const auto & policy : split(policies))
+        {
+            result r;
+            if (!run(policy, keys, capacity, r))
+            {
+                std::cerr << "\nunknown policy " << policy << "\n";
+                return 1;
+            }
+            cout << "\n" << std::left << std::setw(10) << policy << std::right
+                << std::fixed << std::setprecision(4) << std::setw(10) << r.hit_ratio
+                << std::setprecision(2) << std::setw(10) << r.mops
+                << std::setprecision(0) << std::setw(10) << r.p50_ns
+                << std::setw(10) << r.p99_ns;
+        }
+    }
+    cout << "\n done\n";
+    return 0;
+}
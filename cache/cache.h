@@ -5,98 +5,479 @@
 // source : https://github.com/johnpaultaken
 // description :
 //      A generic cache implementation in C++11.
-//      When the cache gets full the least recently used is ejected.
+//      When the cache gets full the least recently used is ejected, or the
+//      item chosen by another eviction policy.
 //----------------------------------------------------------------------------
 
 #pragma once
 
-#include <unordered_map>
-#include <list>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
 #include <string>
 #include <sstream>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "cache_index.h"
+#include "cache_stats.h"
+#include "eviction_policy.h"
+#include "mapped_file.h"
+#include "timing_wheel.h"
 
 /*
 Notes:
 The cache service implements a cache which is organized as
 1.
-an unordered_map with cache lookup key as key
-unordered_map<cache-lookup-key, {cached-value, iterator-to-item-in-2}>
-note: iterators to list<> remain valid after insert or erase, except to erased
-items.
+a slot array preallocated to capacity, one slot per cached item
+vector<{cache-lookup-key, cached-value, hash, expiry, weight, generation, tag}>
+a slot is recycled when its item is ejected. A slot freed by erase or
+expiry goes on a free list; its value is reset to VAL() if VAL is default
+constructible, so that it does not hold on to memory.
 2.
-a list ordered by least recently used
-list<{cache-lookup-key}>
-note: cannot use iterator-to-item-in-1 because iterators to hash containers are
-not valid after an insert.
+a hash index with open addressing of slot-index by hash of the key.
+The INDEX template parameter picks the index; see cache_index.h.
+The hash is kept in the index so that most mismatches are rejected without
+touching the slot, and so that entries can be moved without recomputing
+hashes.
+3.
+an eviction policy tracking slots by slot-index.
+The POLICY template parameter picks the policy; see eviction_policy.h.
+The default lru_policy keeps a list ordered by least recently used, linked
+by 32 bit slot indices, so the list needs no node allocations.
+tinylfu_policy (tinylfu_policy.h) also decides whether a new item is worth
+admitting, which keeps scans of one-off keys from flushing the hot items.
+None of 1, 2 or 3 allocates after the cache is constructed, and the key is
+stored only once, in its slot.
 
 Read Operation:-
-When a key is looked up and found in 1 (O(1)),
+When a key is looked up and found in 2 (O(1)),
+slot-index is used to locate item in 1 (O(1)),
 cached-value is sent as response,
-iterator-to-item-in-2 is used to locate item in 2 (O(1)),
-item-in-2 is removed and moved to end (splice) (O(1)).
+the policy is told of the hit, say lru_policy moves the slot to the most
+recently used end of its list (O(1)).
 
 Write Operation:-
-When a key is added to 1 (O(1)), first the cache size is checked (O(1)),
-and if it is at capacity, the front of list is removed (O(1)), whose
-cache-lookup-key is used to erase corresponding item from 1 (O(1)).
-New key is added to 1 (O(1)), with corresponding item added to end of list (O(1)).
-In case of existing key, the key's value is updated with no change to list
-because typically preceding cache read for it would have updated it once.
-Typically clients would have an expiry date-time inside cached-value,
-and the client would update the cache when it finds cached-value has expired.
+When a key is added, first the cache size is checked (O(1)),
+and if it is at capacity, the policy picks the slot to eject, say
+lru_policy picks the head of its list (O(1)). Its entry in 2 is erased
+(O(1)), and the slot is reused for the new item.
+Otherwise the next unused slot in 1 is taken.
+The policy is told of the new slot and it is added to 2 (O(1)).
+Before that, if any item has a ttl, expired items are erased (see Expiry).
+In case of existing key, the key's value is updated with no change to the
+policy, because typically preceding cache read for it would have updated it
+once.
+
+Expiry:-
+put(key, val, ttl) makes the item expire ttl after the put. put without ttl
+makes it never expire.
+get of an expired item erases it and is a miss (lazy expiry).
+Items are also erased soon after they expire, before they displace live
+items: a timing wheel (timing_wheel.h) with 10 ms ticks schedules each item
+with a ttl in O(1), and is advanced on each put of a new key and on expire().
+The wheel is only allocated at the first put with a ttl, and until then get
+does not read the clock.
+
+Weight:-
+Constructed with a weigher and a max weight, say the bytes of an item, the
+cache also keeps the total weight of its items within max weight. put of a
+new item ejects policy victims until the item fits, and rejects an item
+heavier than max weight, erasing the old value of its key if any. An update
+that makes an item heavier is done as an erase and a put of a new item.
+A value put into a reused slot is swapped in for the old one rather than
+copied into it, so the slot does not keep the old value's heap memory, and
+the weight stays true of the memory held. capacity still bounds the number
+of items.
+
+Lookup:-
+HASH and KEYEQ hash and compare keys. If both are transparent, that is they
+have an is_transparent member type like std::equal_to<>, get, get_shared,
+contains and erase also take any type they accept. Say with string_hash and
+std::equal_to<> a cache<std::string, V> is looked up by std::string_view or
+const char * without building a std::string. The hash of such a value must
+equal the hash of the equal KEY.
+
+Snapshot:-
+For trivially copyable KEY and VAL, save writes the items to a file in the
+order the policy would eject them, least recently used first for lru, as
+{KEY bytes, VAL bytes, remaining ttl} records after a small header. Expired
+items are left out. load maps the file and puts the records in file order,
+so the most recently used items are put last and the recency order is
+restored; if the file holds more items than fit, the ones ejected are the
+least recent. The file is written to a temporary file that is then renamed,
+so a reader never sees a partial file. The format is the memory layout of
+the types, so it is only for a restart of the same build on the same
+machine.
+
+Removal:-
+A removal listener set by set_removal_listener is called with the key, the
+value and the cause, just before an item leaves the cache: when a put
+ejects it, when it is found expired by get or expire, and when it is
+erased. An update of a key does not remove it. It is called from inside the
+cache operation, so it must not call the cache.
+
+Invalidation:-
+bump_generation() makes every item in the cache stale, and invalidate_tag(t)
+every item put with put_tagged(.., t, ..), both in O(1) whatever the number
+of items. The cache keeps a generation number, advanced by each of them.
+An item is stamped with the generation it was put in, and is stale if the
+stamp is older than the last bump, or than the last invalidation of its
+tag. A stale item is a miss, and is reclaimed lazily like an expired one:
+erased by get when found stale, and chosen ahead of live items when a put
+needs room, through a short sweep of the slots and because a stale victim
+is reported as invalidated instead of evicted. Until the first bump or
+invalidation, lookups skip the check.
+A tag is any 64 bit number, say an id or a hash. A hash map gives each tag
+in use a small index into an array of tag generations, which a slot holds,
+so the staleness check never looks up the map. An index is counted by the
+items holding it and freed with the last of them, so the map and array
+never hold more tags than there are items. Snapshots do not keep tags.
+
+Batch:-
+multi_get and multi_put look up keys in batches of 16, in three passes over
+a batch. The first hashes every key and prefetches its index position, the
+second finds the slots with a matching hash and prefetches them, and the
+third compares keys and does the get or put as usual. So instead of each
+lookup waiting on two dependent cache misses in turn, the misses of a whole
+batch are waited on together. A batch behaves exactly like the same gets or
+puts one after the other; the prefetches are only hints.
+
+Stats:-
+Define CACHE_STATS to count hits, misses, insertions, updates, evictions and
+expirations, in O(1) per operation; see cache_stats.h. stats() returns a
+snapshot of them.
 */
 namespace utils
 {
-using std::unordered_map;
-using std::list;
 
-template<typename KEY, typename VAL>
+#if __cplusplus >= 201703L
+// Transparent hash of strings, for lookups by std::string_view and
+// const char * in a cache of std::string keys.
+struct string_hash
+{
+    using is_transparent = void;
+
+    size_t operator()(std::string_view s) const noexcept
+    {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+#endif
+
+// why an item left the cache; see Removal.
+enum class removal_cause
+{
+    evicted,    // ejected to make room.
+    expired,    // its ttl passed.
+    erased,     // erased, or rejected by an update too heavy to fit.
+    invalidated // its tag or generation was invalidated.
+};
+
+namespace detail
+{
+
+template<typename T, typename = void>
+struct is_transparent : std::false_type
+{
+};
+
+template<typename T>
+struct is_transparent<
+    T, typename std::conditional<true, void, typename T::is_transparent>::type
+> : std::true_type
+{
+};
+
+} // namespace detail
+
+template<
+    typename KEY, typename VAL,
+    typename POLICY = lru_policy, typename INDEX = flat_index,
+    typename HASH = std::hash<KEY>, typename KEYEQ = std::equal_to<KEY>
+>
 class cache
 {
+    // K if lookups by K are enabled, that is if HASH and KEYEQ are
+    // transparent.
+    template<typename K>
+    using transparent_key = typename std::enable_if<
+        detail::is_transparent<HASH>::value
+            && detail::is_transparent<KEYEQ>::value,
+        K
+    >::type;
+
 public:
-    cache(size_t capacity = 1024) : _capacity(capacity)
+    using clock = timing_wheel::clock;
+    using weigher_type = std::function<size_t(const KEY &, const VAL &)>;
+    using listener_type =
+        std::function<void(const KEY &, const VAL &, removal_cause)>;
+
+    // Param: capacity - must be less than 2^32 - 1.
+    cache(size_t capacity = 1024) :
+        cache(capacity, std::numeric_limits<size_t>::max(), weigher_type{})
+    {
+    }
+
+    // Params:
+    //        capacity: maximum number of items, less than 2^32 - 1.
+    //        max_weight: maximum total weight of items.
+    //        weigher: weight of an item, say its size in bytes.
+    cache(size_t capacity, size_t max_weight, weigher_type weigher) :
+        _capacity(capacity),
+        _lookup(capacity),
+        _policy(capacity),
+        _weigher(std::move(weigher)),
+        _weight(0),
+        _max_weight(max_weight),
+        _generation(0),
+        _valid_from(0),
+        _sweep(0)
     {
+        _slots.reserve(capacity);
+        _free.reserve(capacity);
     }
 
     // if found in cache, copies to val and return true.
     bool get(const KEY & key, VAL & val)
     {
-        auto itr = _lookup.find(key);
-        if (itr == _lookup.end())
-        {
-            return false;
-        }
-        else
-        {
-            val = itr->second._val;
-            auto end_splice = itr->second._itr_lru; ++end_splice;
-            _lru.splice( _lru.end(), _lru, itr->second._itr_lru, end_splice);
-        }
-        return true;
+        return copy(lookup(key), val);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    bool get(const K & key, VAL & val)
+    {
+        return copy(lookup(key), val);
     }
 
-    void put(const KEY & key, const VAL & val)
+    // Return: the cached value without copying it, or nullptr if not found.
+    // It is valid until the next call to put, erase or expire.
+    const VAL * get(const KEY & key)
     {
-        auto itr = _lookup.find(key);
-        if (itr == _lookup.end())
+        return lookup(key);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    const VAL * get(const K & key)
+    {
+        return lookup(key);
+    }
+
+    // Same as get, but does not modify the cache other than through
+    // POLICY::on_hit and on_miss; an expired item is a miss but is left for
+    // put or expire to erase. So for a policy with concurrent_hits, like
+    // clock_policy, many threads can call it at the same time under a
+    // shared lock.
+    bool get_shared(const KEY & key, VAL & val) const
+    {
+        return copy(lookup_shared(key), val);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    bool get_shared(const K & key, VAL & val) const
+    {
+        return copy(lookup_shared(key), val);
+    }
+
+    const VAL * get_shared(const KEY & key) const
+    {
+        return lookup_shared(key);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    const VAL * get_shared(const K & key) const
+    {
+        return lookup_shared(key);
+    }
+
+    // get a batch of keys; see Batch.
+    // Params:
+    //        keys: keys to look up.
+    //        vals: OUT the value of each key as get(key) returns it,
+    //              nullptr if not found.
+    // Return: number of keys found.
+    size_t multi_get(const std::vector<KEY> & keys, std::vector<const VAL *> & vals)
+    {
+        vals.resize(keys.size());
+        return multi_get(keys.begin(), keys.end(), vals.data());
+    }
+
+    // Same as above for keys in [first, last). *first is a KEY, or converts
+    // to a const KEY & like std::reference_wrapper<const KEY>.
+    // vals must have room for last - first values.
+    template<typename ITR>
+    size_t multi_get(ITR first, ITR last, const VAL ** vals)
+    {
+        return lookup_batch(
+            first, last, vals,
+            [this](uint32_t s, uint64_t hash){ return use(s, hash); }
+        );
+    }
+
+    // multi_get the way get_shared gets.
+    size_t multi_get_shared(
+        const std::vector<KEY> & keys, std::vector<const VAL *> & vals
+    ) const
+    {
+        vals.resize(keys.size());
+        return multi_get_shared(keys.begin(), keys.end(), vals.data());
+    }
+
+    template<typename ITR>
+    size_t multi_get_shared(ITR first, ITR last, const VAL ** vals) const
+    {
+        static_assert(
+            POLICY::concurrent_hits,
+            "get_shared needs a policy with concurrent_hits"
+        );
+        return lookup_batch(
+            first, last, vals,
+            [this](uint32_t s, uint64_t hash){ return use_shared(s, hash); }
+        );
+    }
+
+    // Return: true if key is in the cache and not expired.
+    // Unlike get, it is not a use of the item for the policy.
+    bool contains(const KEY & key) const
+    {
+        return contains_key(key);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    bool contains(const K & key) const
+    {
+        return contains_key(key);
+    }
+
+    // Return: the cached value, or nullptr if not found or expired.
+    // Unlike get, it is not a use of the item for the policy.
+    const VAL * peek(const KEY & key) const
+    {
+        return peek_key(key);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    const VAL * peek(const K & key) const
+    {
+        return peek_key(key);
+    }
+
+    // put an item that never expires.
+    // Return: false if the item was rejected as heavier than max weight.
+    bool put(const KEY & key, const VAL & val)
+    {
+        return put_until(key, val, hash_of(key), clock::time_point::max());
+    }
+
+    // put an item that expires ttl from now.
+    // Return: false if the item was rejected as heavier than max weight.
+    bool put(const KEY & key, const VAL & val, clock::duration ttl)
+    {
+        return put_until(key, val, hash_of(key), clock::now() + ttl);
+    }
+
+    // put an item that never expires, tagged for invalidate_tag.
+    // Params:
+    //        tag: names a group of items; see Invalidation.
+    // Return: false if the item was rejected as heavier than max weight.
+    bool put_tagged(const KEY & key, const VAL & val, uint64_t tag)
+    {
+        return put_until(key, val, hash_of(key), clock::time_point::max(), &tag);
+    }
+
+    // put a tagged item that expires ttl from now.
+    bool put_tagged(
+        const KEY & key, const VAL & val, uint64_t tag, clock::duration ttl
+    )
+    {
+        return put_until(key, val, hash_of(key), clock::now() + ttl, &tag);
+    }
+
+    // make every item put with tag stale, in O(1); see Invalidation.
+    void invalidate_tag(uint64_t tag)
+    {
+        auto itr = _tag_index.find(tag);
+        if (itr != _tag_index.end())
         {
-            if (_lookup.size() >= _capacity)
-            {
-                _lookup.erase(*_lru.begin());
-                _lru.pop_front();
-            }
-            _lookup.emplace(key, value_type{val, _lru.insert(_lru.end(), key)});
+            _tags[itr->second]._invalidated = ++_generation;
         }
-        else
+    }
+
+    // make every item in the cache stale, in O(1); see Invalidation.
+    void bump_generation()
+    {
+        _valid_from = ++_generation;
+    }
+
+    // put a batch of items that never expire; see Batch.
+    // Return: number of items put, that is not rejected as too heavy.
+    size_t multi_put(const std::vector<std::pair<KEY, VAL>> & items)
+    {
+        return multi_put(items.begin(), items.end());
+    }
+
+    // put a batch of items that expire ttl from now.
+    size_t multi_put(
+        const std::vector<std::pair<KEY, VAL>> & items, clock::duration ttl
+    )
+    {
+        return multi_put(items.begin(), items.end(), ttl);
+    }
+
+    // Same as above for items in [first, last). first->first is a KEY, or
+    // converts to a const KEY &, and first->second is a VAL.
+    template<typename ITR>
+    size_t multi_put(ITR first, ITR last)
+    {
+        return put_batch(first, last, clock::time_point::max());
+    }
+
+    template<typename ITR>
+    size_t multi_put(ITR first, ITR last, clock::duration ttl)
+    {
+        return put_batch(first, last, clock::now() + ttl);
+    }
+
+    // Return: true if key was in the cache.
+    bool erase(const KEY & key)
+    {
+        return erase_key(key);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    bool erase(const K & key)
+    {
+        return erase_key(key);
+    }
+
+    // erase the expired items.
+    void expire()
+    {
+        if (_wheel)
         {
-            // Just update _lookup. No change to _lru.
-            itr->second._val = val;
+            _wheel->advance(clock::now(), [this](uint32_t s){
+                remove(s, removal_cause::expired);
+                _counters.expiration();
+            });
         }
     }
 
+    // Return: number of items, including expired or stale ones not yet
+    //         erased.
     inline size_t size()
     {
-        return _lookup.size();
+        return _slots.size() - _free.size();
     }
 
     inline size_t capacity()
@@ -104,6 +485,126 @@ public:
         return _capacity;
     }
 
+    // Return: total weight of items; 0 without a weigher.
+    inline size_t weight()
+    {
+        return _weight;
+    }
+
+    inline size_t max_weight()
+    {
+        return _max_weight;
+    }
+
+    // call listener for every item removed from now on; see Removal.
+    // An empty listener turns it off.
+    void set_removal_listener(listener_type listener)
+    {
+        _listener = std::move(listener);
+    }
+
+    // enabled is false in the snapshot if CACHE_STATS is not defined.
+    cache_stats stats() const
+    {
+        return _counters.snapshot();
+    }
+
+    // write the items to a file at path; see Snapshot.
+    // Return: true if the file was written.
+    bool save(const std::string & path) const
+    {
+        static_assert(
+            std::is_trivially_copyable<KEY>::value
+                && std::is_trivially_copyable<VAL>::value,
+            "save needs trivially copyable KEY and VAL"
+        );
+        auto now = clock::now();
+        auto live = [this, now](uint32_t s){
+            return _slots[s]._expires > now && !(_generation && stale(s));
+        };
+        snapshot_header header = snapshot_header::make();
+        _policy.for_each([&](uint32_t s){ header._count += live(s); });
+
+        auto temp = path + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            _policy.for_each([&](uint32_t s){
+                if (live(s))
+                {
+                    const auto & item = _slots[s];
+                    int64_t ttl = (item._expires == clock::time_point::max())
+                        ? -1
+                        : std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            item._expires - now
+                        ).count();
+                    out.write(reinterpret_cast<const char *>(&item._key), sizeof(KEY));
+                    out.write(reinterpret_cast<const char *>(&item._val), sizeof(VAL));
+                    out.write(reinterpret_cast<const char *>(&ttl), sizeof(ttl));
+                }
+            });
+            if (!out.flush())
+            {
+                std::remove(temp.c_str());
+                return false;
+            }
+        }
+        return std::rename(temp.c_str(), path.c_str()) == 0;
+    }
+
+    // put the items of a file written by save; see Snapshot.
+    // Return: false if the file could not be read or is not a snapshot of
+    //         this KEY and VAL. Then the cache is unchanged.
+    bool load(const std::string & path)
+    {
+        static_assert(
+            std::is_trivially_copyable<KEY>::value
+                && std::is_trivially_copyable<VAL>::value,
+            "load needs trivially copyable KEY and VAL"
+        );
+        mapped_file file(path);
+        snapshot_header header;
+        if (!file.is_open() || file.size() < sizeof(header))
+        {
+            return false;
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        auto expected = snapshot_header::make();
+        const size_t record_size = sizeof(KEY) + sizeof(VAL) + sizeof(int64_t);
+        if (std::memcmp(header._magic, expected._magic, sizeof(header._magic))
+            || header._version != expected._version
+            || header._key_size != expected._key_size
+            || header._val_size != expected._val_size
+            || (file.size() - sizeof(header)) / record_size != header._count
+            || (file.size() - sizeof(header)) % record_size)
+        {
+            return false;
+        }
+
+        // raw storage, since KEY and VAL need not be default constructible.
+        typename std::aligned_storage<sizeof(KEY), alignof(KEY)>::type key;
+        typename std::aligned_storage<sizeof(VAL), alignof(VAL)>::type val;
+        auto p = file.data() + sizeof(header);
+        for (uint64_t i=0; i<header._count; ++i, p += record_size)
+        {
+            int64_t ttl;
+            std::memcpy(&key, p, sizeof(KEY));
+            std::memcpy(&val, p + sizeof(KEY), sizeof(VAL));
+            std::memcpy(&ttl, p + sizeof(KEY) + sizeof(VAL), sizeof(ttl));
+            const auto & k = *reinterpret_cast<const KEY *>(&key);
+            const auto & v = *reinterpret_cast<const VAL *>(&val);
+            if (ttl < 0)
+            {
+                put(k, v);
+            }
+            else
+            {
+                put(k, v, std::chrono::nanoseconds(ttl));
+            }
+        }
+        return true;
+    }
+
     // check the consistency of internal data structures.
     // Params:
     //        details: OUT returns the detailed consistency check results.
@@ -112,9 +613,15 @@ public:
     {
         bool ret = true;
         std::ostringstream oss;
-        for(const auto & key : _lru)
-        {
-            if (_lookup.find(key) == _lookup.end())
+        size_t count = 0;
+        std::vector<uint32_t> tagged(_tags.size(), 0);
+        _policy.for_each([&](uint32_t s){
+            if (_slots[s]._tag < tagged.size())
+            {
+                ++tagged[_slots[s]._tag];
+            }
+            const auto & key = _slots[s]._key;
+            if (find(key, hash_of(key)) != s || ++count > size())
             {
                 ret = false;
                 oss << " " << key << ":error";
@@ -123,20 +630,544 @@ public:
             {
                 oss << " " << key << ":ok";
             }
+        });
+        if (count != size())
+        {
+            ret = false;
+            oss << " policy:error";
+        }
+        // every tag in use is counted by the slots holding it, and no other.
+        bool tags_ok = _tag_index.size() + _free_tags.size() == _tags.size();
+        for (const auto & t : _tag_index)
+        {
+            tags_ok = tags_ok && _tags[t.second]._tag == t.first
+                && _tags[t.second]._slots == tagged[t.second];
+        }
+        if (!tags_ok)
+        {
+            ret = false;
+            oss << " tags:error";
         }
         details = oss.str();
         return ret;
     }
 private:
-    using list_type = list<KEY>;
-    struct value_type{
+    static const uint32_t npos = INDEX::npos;
+    // keys looked up together by multi_get and multi_put.
+    static const size_t batch_size = 16;
+    // tag index of an untagged slot.
+    static const uint32_t no_tag = 0xFFFFFFFF;
+    // slots a put looks at for stale items before ejecting a live one.
+    static const size_t sweep_step = 8;
+
+    struct snapshot_header
+    {
+        char _magic[8];
+        uint32_t _version;
+        uint32_t _key_size;
+        uint32_t _val_size;
+        uint32_t _unused;
+        uint64_t _count;
+
+        static snapshot_header make()
+        {
+            snapshot_header h;
+            std::memcpy(h._magic, "UCACHE\0\0", sizeof(h._magic));
+            h._version = 1;
+            h._key_size = uint32_t(sizeof(KEY));
+            h._val_size = uint32_t(sizeof(VAL));
+            h._unused = 0;
+            h._count = 0;
+            return h;
+        }
+    };
+
+    struct slot
+    {
+        KEY _key;
         VAL _val;
-        typename list_type::iterator _itr_lru;
+        uint64_t _hash;
+        // max if the item never expires.
+        clock::time_point _expires;
+        size_t _weight;
+        // generation put in; max if the slot is free.
+        uint64_t _generation;
+        // index in _tags, or no_tag.
+        uint32_t _tag;
     };
-    using map_type = unordered_map<KEY, value_type>;
+
+    struct tag_state
+    {
+        uint64_t _tag;
+        // generation last invalidated in.
+        uint64_t _invalidated;
+        // number of slots holding the tag.
+        uint32_t _slots;
+    };
+
+    template<typename K>
+    const VAL * lookup(const K & key)
+    {
+        auto hash = hash_of(key);
+        return use(find(key, hash), hash);
+    }
+
+    // Return: the value of slot s, the result of a find for hash, or
+    //         nullptr if not found or expired.
+    const VAL * use(uint32_t s, uint64_t hash)
+    {
+        if (s != npos && _wheel && expired(s))
+        {
+            remove(s, removal_cause::expired);
+            _counters.expiration();
+            s = npos;
+        }
+        if (s != npos && _generation && stale(s))
+        {
+            remove(s, removal_cause::invalidated);
+            _counters.invalidation();
+            s = npos;
+        }
+        if (s == npos)
+        {
+            _counters.miss(false);
+            _policy.on_miss(hash);
+            return nullptr;
+        }
+        _counters.hit(false);
+        _policy.on_hit(s);
+        return &_slots[s]._val;
+    }
+
+    template<typename K>
+    const VAL * lookup_shared(const K & key) const
+    {
+        static_assert(
+            POLICY::concurrent_hits,
+            "get_shared needs a policy with concurrent_hits"
+        );
+        auto hash = hash_of(key);
+        return use_shared(find(key, hash), hash);
+    }
+
+    const VAL * use_shared(uint32_t s, uint64_t hash) const
+    {
+        if (s == npos || (_wheel && expired(s)) || (_generation && stale(s)))
+        {
+            _counters.miss(true);
+            _policy.on_miss(hash);
+            return nullptr;
+        }
+        _counters.hit(true);
+        _policy.on_hit(s);
+        return &_slots[s]._val;
+    }
+
+    template<typename K>
+    bool contains_key(const K & key) const
+    {
+        return peek_key(key) != nullptr;
+    }
+
+    template<typename K>
+    const VAL * peek_key(const K & key) const
+    {
+        auto s = find(key, hash_of(key));
+        if (s == npos || (_wheel && expired(s)) || (_generation && stale(s)))
+        {
+            return nullptr;
+        }
+        return &_slots[s]._val;
+    }
+
+    template<typename K>
+    bool erase_key(const K & key)
+    {
+        auto s = find(key, hash_of(key));
+        if (s == npos)
+        {
+            return false;
+        }
+        remove(s, removal_cause::erased);
+        return true;
+    }
+
+    static bool copy(const VAL * p, VAL & val)
+    {
+        if (p)
+        {
+            val = *p;
+        }
+        return p != nullptr;
+    }
+
+    // Return: number of keys found.
+    template<typename ITR, typename USE>
+    size_t lookup_batch(ITR first, ITR last, const VAL ** vals, USE use) const
+    {
+        size_t found = 0;
+        const KEY * keys[batch_size];
+        uint64_t hashes[batch_size];
+        while (first != last)
+        {
+            size_t n = 0;
+            for (; n < batch_size && first != last; ++n, ++first)
+            {
+                const KEY & key = *first;
+                keys[n] = &key;
+                hashes[n] = hash_of(key);
+                _lookup.prefetch(hashes[n]);
+            }
+            for (size_t i=0; i<n; ++i)
+            {
+                prefetch_slots(hashes[i]);
+            }
+            for (size_t i=0; i<n; ++i)
+            {
+                auto p = use(find(*keys[i], hashes[i]), hashes[i]);
+                found += (p != nullptr);
+                *vals++ = p;
+            }
+        }
+        return found;
+    }
+
+    // Return: number of items put.
+    template<typename ITR>
+    size_t put_batch(ITR first, ITR last, clock::time_point expires)
+    {
+        size_t done = 0;
+        uint64_t hashes[batch_size];
+        while (first != last)
+        {
+            auto begin = first;
+            size_t n = 0;
+            for (; n < batch_size && first != last; ++n, ++first)
+            {
+                const KEY & key = first->first;
+                hashes[n] = hash_of(key);
+                _lookup.prefetch(hashes[n]);
+            }
+            for (size_t i=0; i<n; ++i)
+            {
+                prefetch_slots(hashes[i]);
+            }
+            for (size_t i=0; i<n; ++i, ++begin)
+            {
+                const KEY & key = begin->first;
+                done += put_until(key, begin->second, hashes[i], expires);
+            }
+        }
+        return done;
+    }
+
+    // prefetch the slots a find for hash will compare keys with.
+    void prefetch_slots(uint64_t hash) const
+    {
+        _lookup.find(hash, [this](uint32_t s){
+            detail::prefetch(&_slots[s]);
+            return false;
+        });
+    }
+
+    // Params:
+    //        tag: the tag of the item, nullptr if untagged.
+    bool put_until(
+        const KEY & key, const VAL & val, uint64_t hash, clock::time_point expires,
+        const uint64_t * tag = nullptr
+    )
+    {
+        auto s = find(key, hash);
+        size_t weight = _weigher ? _weigher(key, val) : 0;
+        bool update = (s != npos);
+        if (s != npos && weight > _slots[s]._weight)
+        {
+            if (weight > _max_weight)
+            {
+                remove(s, removal_cause::erased);
+                return false;
+            }
+            // may need to eject others; so put it afresh.
+            erase_slot(s);
+            s = npos;
+        }
+        if (s == npos)
+        {
+            if (weight > _max_weight)
+            {
+                return false;
+            }
+            // reclaim expired and stale items before ejecting a live one.
+            expire();
+            if (_generation && _free.empty()
+                && (_slots.size() >= _capacity || _weight + weight > _max_weight))
+            {
+                sweep_stale();
+            }
+            while (_weight + weight > _max_weight)
+            {
+                auto victim = _policy.victim(hash);
+                remove(victim, eviction_cause(victim));
+            }
+            if (!_free.empty())
+            {
+                s = _free.back();
+                _free.pop_back();
+                set_slot(s, key, val, hash, expires, weight, tag);
+            }
+            else if (_slots.size() >= _capacity)
+            {
+                if (_capacity == 0)
+                {
+                    return false;
+                }
+                // eject the victim of the policy and reuse its slot.
+                s = _policy.victim(hash);
+                notify(s, eviction_cause(s));
+                _policy.on_erase(s);
+                _lookup.erase(_slots[s]._hash, s);
+                _weight -= _slots[s]._weight;
+                set_slot(s, key, val, hash, expires, weight, tag);
+            }
+            else
+            {
+                s = uint32_t(_slots.size());
+                _slots.push_back(
+                    slot{key, val, hash, expires, weight, _generation, no_tag}
+                );
+                retag(s, tag);
+            }
+            _weight += weight;
+            if (update)
+            {
+                _counters.update();
+            }
+            else
+            {
+                _counters.insertion();
+            }
+            _policy.on_insert(s, hash);
+            _lookup.insert(hash, s);
+        }
+        else
+        {
+            // Just update the value, expiry and tag. No change to the policy.
+            _counters.update();
+            replace(_slots[s]._val, val);
+            _slots[s]._expires = expires;
+            _weight -= _slots[s]._weight - weight;
+            _slots[s]._weight = weight;
+            _slots[s]._generation = _generation;
+            retag(s, tag);
+        }
+        schedule(s);
+        return true;
+    }
+
+    void set_slot(
+        uint32_t s, const KEY & key, const VAL & val, uint64_t hash,
+        clock::time_point expires, size_t weight, const uint64_t * tag
+    )
+    {
+        _slots[s]._key = key;
+        replace(_slots[s]._val, val);
+        _slots[s]._hash = hash;
+        _slots[s]._expires = expires;
+        _slots[s]._weight = weight;
+        _slots[s]._generation = _generation;
+        retag(s, tag);
+    }
+
+    // give slot s the index of tag, or no_tag for nullptr, releasing the
+    // index it held.
+    void retag(uint32_t s, const uint64_t * tag)
+    {
+        auto old = _slots[s]._tag;
+        _slots[s]._tag = no_tag;
+        if (tag)
+        {
+            auto ins = _tag_index.emplace(*tag, uint32_t(_tags.size()));
+            if (ins.second)
+            {
+                if (!_free_tags.empty())
+                {
+                    ins.first->second = _free_tags.back();
+                    _free_tags.pop_back();
+                    _tags[ins.first->second] = tag_state{*tag, 0, 0};
+                }
+                else
+                {
+                    _tags.push_back(tag_state{*tag, 0, 0});
+                }
+            }
+            _slots[s]._tag = ins.first->second;
+            ++_tags[ins.first->second]._slots;
+        }
+        release_tag(old);
+    }
+
+    // drop a slot's hold on tag index t; the last one frees it.
+    void release_tag(uint32_t t)
+    {
+        if (t != no_tag && --_tags[t]._slots == 0)
+        {
+            _tag_index.erase(_tags[t]._tag);
+            _free_tags.push_back(t);
+        }
+    }
+
+    // keep the timing wheel in step with the expiry of slot s.
+    void schedule(uint32_t s)
+    {
+        if (_slots[s]._expires == clock::time_point::max())
+        {
+            if (_wheel)
+            {
+                _wheel->cancel(s);
+            }
+            return;
+        }
+        if (!_wheel)
+        {
+            _wheel.reset(
+                new timing_wheel(_capacity, std::chrono::milliseconds(10))
+            );
+        }
+        _wheel->schedule(s, _slots[s]._expires);
+    }
+
+    bool expired(uint32_t s) const
+    {
+        return _slots[s]._expires <= clock::now();
+    }
+
+    // Return: true if slot s was put before the last bump_generation or
+    //         invalidate_tag of its tag. Never true of a free slot.
+    bool stale(uint32_t s) const
+    {
+        const auto & sl = _slots[s];
+        return sl._generation < _valid_from
+            || (sl._tag != no_tag && sl._generation < _tags[sl._tag]._invalidated);
+    }
+
+    // erase the stale items among the next sweep_step slots.
+    void sweep_stale()
+    {
+        for (size_t i=0; i<sweep_step && i<_slots.size(); ++i)
+        {
+            auto s = uint32_t(_sweep);
+            _sweep = (_sweep + 1) % _slots.size();
+            if (stale(s))
+            {
+                remove(s, removal_cause::invalidated);
+                _counters.invalidation();
+            }
+        }
+    }
+
+    // Return: why victim s is ejected, counting it.
+    removal_cause eviction_cause(uint32_t s)
+    {
+        if (_generation && stale(s))
+        {
+            _counters.invalidation();
+            return removal_cause::invalidated;
+        }
+        _counters.eviction();
+        return removal_cause::evicted;
+    }
+
+    // erase slot s, telling the listener why.
+    void remove(uint32_t s, removal_cause cause)
+    {
+        notify(s, cause);
+        erase_slot(s);
+    }
+
+    void notify(uint32_t s, removal_cause cause)
+    {
+        if (_listener)
+        {
+            _listener(_slots[s]._key, _slots[s]._val, cause);
+        }
+    }
+
+    void erase_slot(uint32_t s)
+    {
+        if (_wheel)
+        {
+            _wheel->cancel(s);
+        }
+        _policy.on_erase(s);
+        _lookup.erase(_slots[s]._hash, s);
+        _weight -= _slots[s]._weight;
+        _slots[s]._weight = 0;
+        _slots[s]._generation = std::numeric_limits<uint64_t>::max();
+        release_tag(_slots[s]._tag);
+        _slots[s]._tag = no_tag;
+        release(_slots[s]._val, std::is_default_constructible<VAL>{});
+        _free.push_back(s);
+    }
+
+    // swap in a copy, since copying or even moving a short string into the
+    // old value keeps the old value's heap buffer.
+    static void replace(VAL & old, VAL val)
+    {
+        using std::swap;
+        swap(old, val);
+    }
+
+    static void release(VAL & val, std::true_type)
+    {
+        replace(val, VAL());
+    }
+
+    static void release(VAL &, std::false_type)
+    {
+    }
+
+    template<typename K>
+    static uint64_t hash_of(const K & key)
+    {
+        return detail::mix_hash(uint64_t(HASH{}(key)));
+    }
+
+    template<typename K>
+    uint32_t find(const K & key, uint64_t hash) const
+    {
+        return _lookup.find(
+            hash,
+            [this, &key](uint32_t s){ return KEYEQ{}(_slots[s]._key, key); }
+        );
+    }
 
     size_t _capacity;
-    map_type _lookup;
-    list_type _lru;
+    std::vector<slot> _slots;
+    // slots freed by erase or expiry.
+    std::vector<uint32_t> _free;
+    INDEX _lookup;
+    POLICY _policy;
+    // allocated at the first put with a ttl.
+    std::unique_ptr<timing_wheel> _wheel;
+    weigher_type _weigher;
+    listener_type _listener;
+    size_t _weight;
+    size_t _max_weight;
+    // advanced by bump_generation and invalidate_tag.
+    uint64_t _generation;
+    // items put in an earlier generation are stale.
+    uint64_t _valid_from;
+    // index in _tags of each tag held by a slot.
+    std::unordered_map<uint64_t, uint32_t> _tag_index;
+    std::vector<tag_state> _tags;
+    // indices in _tags no tag holds.
+    std::vector<uint32_t> _free_tags;
+    // next slot sweep_stale looks at.
+    size_t _sweep;
+#ifdef CACHE_STATS
+    mutable detail::cache_counters _counters;
+#else
+    detail::null_cache_counters _counters;
+#endif
 };
 }
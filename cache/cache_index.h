@@ -0,0 +1,391 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      Hash indices for cache in C++11.
+//      An index maps a key hash to the slot holding the key. Both indices
+//      here use open addressing in flat arrays sized once at construction,
+//      so a lookup touches one or two cache lines and nothing is allocated
+//      after construction.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTILS_CACHE_INDEX_SSE2
+#include <emmintrin.h>
+#endif
+
+/*
+Notes:
+An index is a template parameter of cache. It has the interface
+    INDEX(size_t capacity)
+        capacity is the maximum number of slots indexed at the same time.
+    template<typename MATCH> uint32_t find(uint64_t hash, MATCH && match) const
+        returns the slot for which match(slot) is true, or npos.
+    void insert(uint64_t hash, uint32_t slot)
+        the key of slot must not be in the index already.
+    void erase(uint64_t hash, uint32_t slot)
+        slot must be in the index.
+    void prefetch(uint64_t hash) const
+        hint the cpu to load the memory find(hash) touches first, so that
+        the lookups of a batch of keys wait on memory in parallel.
+An index does not know about keys, the cache gives find a functor to match
+a candidate slot against the key being looked up. hash must be well mixed
+in all its bits; cache mixes std::hash with detail::mix_hash before giving
+it to the index.
+
+flat_index:
+    linear probing over {slot, hash} entries at load factor at most 0.5.
+    Erase shifts back the entries that follow, so there are no tombstones.
+    Best when lookups mostly hit.
+
+swiss_index:
+    groups of 16 one byte control words holding 7 bits of the hash, probed
+    16 at a time with SSE2 (a scalar loop without SSE2), in front of an
+    array of {slot, hash} entries. A miss usually costs one load of 16
+    control bytes, so it is best when lookups often miss.
+    Erase leaves a tombstone only if the group was full. When tombstones
+    build up, the index is rebuilt in place using a buffer reserved at
+    construction.
+*/
+namespace utils
+{
+
+namespace detail
+{
+
+// hint the cpu to load the cache line at p; no effect on the result.
+inline void prefetch(const void * p)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(p);
+#elif defined(UTILS_CACHE_INDEX_SSE2)
+    _mm_prefetch(static_cast<const char *>(p), _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
+// spread the bits of a std::hash value over all 64 bits, since std::hash
+// of integers is often the identity.
+inline uint64_t mix_hash(uint64_t h)
+{
+    h ^= h >> 32;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+} // namespace detail
+
+class flat_index
+{
+public:
+    static const uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    explicit flat_index(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < 2 * capacity)
+        {
+            size *= 2;
+        }
+        _mask = size - 1;
+        _entries.assign(size, entry{npos, 0});
+    }
+
+    template<typename MATCH>
+    uint32_t find(uint64_t hash, MATCH && match) const
+    {
+        auto h = uint32_t(hash);
+        for (size_t i = h & _mask; ; i = (i + 1) & _mask)
+        {
+            const auto & e = _entries[i];
+            if (e._slot == npos)
+            {
+                return npos;
+            }
+            if (e._hash == h && match(e._slot))
+            {
+                return e._slot;
+            }
+        }
+    }
+
+    void insert(uint64_t hash, uint32_t slot)
+    {
+        auto h = uint32_t(hash);
+        auto i = h & _mask;
+        while (_entries[i]._slot != npos)
+        {
+            i = (i + 1) & _mask;
+        }
+        _entries[i] = entry{slot, h};
+    }
+
+    void erase(uint64_t hash, uint32_t slot)
+    {
+        auto h = uint32_t(hash);
+        auto i = h & _mask;
+        while (_entries[i]._slot != slot)
+        {
+            i = (i + 1) & _mask;
+        }
+
+        // backward shift the entries that follow, so no tombstone is needed.
+        for (auto j = (i + 1) & _mask; _entries[j]._slot != npos; j = (j + 1) & _mask)
+        {
+            auto home = _entries[j]._hash & _mask;
+            if (((j - home) & _mask) >= ((j - i) & _mask))
+            {
+                _entries[i] = _entries[j];
+                i = j;
+            }
+        }
+        _entries[i]._slot = npos;
+    }
+
+    void prefetch(uint64_t hash) const
+    {
+        detail::prefetch(&_entries[uint32_t(hash) & _mask]);
+    }
+
+private:
+    struct entry
+    {
+        uint32_t _slot;
+        uint32_t _hash;
+    };
+
+    size_t _mask;
+    std::vector<entry> _entries;
+};
+
+class swiss_index
+{
+public:
+    static const uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    explicit swiss_index(size_t capacity) : _live{0}, _tombstones{0}
+    {
+        // live entries at most 3/4 of positions.
+        size_t groups = 1;
+        while (groups * group_size * 3 < capacity * 4)
+        {
+            groups *= 2;
+        }
+        _group_mask = groups - 1;
+        _ctrl.assign(groups * group_size, int8_t(empty));
+        _entries.resize(groups * group_size);
+        _max_used = groups * group_size * 7 / 8;
+        _rebuild.reserve(capacity);
+    }
+
+    template<typename MATCH>
+    uint32_t find(uint64_t hash, MATCH && match) const
+    {
+        auto h = uint32_t(hash);
+        auto g = h1(h) & _group_mask;
+        for (size_t step = 1; ; g = (g + step++) & _group_mask)
+        {
+            auto base = g * group_size;
+            for (auto bits = match_byte(base, h2(h)); bits; bits &= bits - 1)
+            {
+                const auto & e = _entries[base + lowest_bit(bits)];
+                if (e._hash == h && match(e._slot))
+                {
+                    return e._slot;
+                }
+            }
+            if (match_byte(base, empty))
+            {
+                return npos;
+            }
+        }
+    }
+
+    void insert(uint64_t hash, uint32_t slot)
+    {
+        auto h = uint32_t(hash);
+        auto i = free_position(h);
+        if (_ctrl[i] == empty)
+        {
+            if (_live + _tombstones >= _max_used)
+            {
+                rebuild();
+                i = free_position(h);
+            }
+        }
+        else
+        {
+            --_tombstones;
+        }
+        _ctrl[i] = h2(h);
+        _entries[i] = entry{slot, h};
+        ++_live;
+    }
+
+    void erase(uint64_t hash, uint32_t slot)
+    {
+        auto h = uint32_t(hash);
+        auto g = h1(h) & _group_mask;
+        for (size_t step = 1; ; g = (g + step++) & _group_mask)
+        {
+            auto base = g * group_size;
+            for (auto bits = match_byte(base, h2(h)); bits; bits &= bits - 1)
+            {
+                auto i = base + lowest_bit(bits);
+                if (_entries[i]._slot == slot)
+                {
+                    // a probe stops at a group with an empty position, so
+                    // if there is one no probe ever went past this group.
+                    if (match_byte(base, empty))
+                    {
+                        _ctrl[i] = empty;
+                    }
+                    else
+                    {
+                        _ctrl[i] = deleted;
+                        ++_tombstones;
+                    }
+                    --_live;
+                    return;
+                }
+            }
+        }
+    }
+
+    void prefetch(uint64_t hash) const
+    {
+        auto base = (h1(uint32_t(hash)) & _group_mask) * group_size;
+        detail::prefetch(&_ctrl[base]);
+        detail::prefetch(&_entries[base]);
+    }
+
+private:
+    static const size_t group_size = 16;
+    static const int8_t empty = -128;       // 0x80
+    static const int8_t deleted = -2;       // 0xFE
+    // full positions hold h2 in 0..127
+
+    struct entry
+    {
+        uint32_t _slot;
+        uint32_t _hash;
+    };
+
+    static size_t h1(uint32_t h)
+    {
+        return h >> 7;
+    }
+
+    static int8_t h2(uint32_t h)
+    {
+        return int8_t(h & 0x7F);
+    }
+
+    // bit i set if control byte i of the group at base is b.
+    uint32_t match_byte(size_t base, int8_t b) const
+    {
+#ifdef UTILS_CACHE_INDEX_SSE2
+        auto ctrl = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(&_ctrl[base])
+        );
+        return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b))));
+#else
+        uint32_t bits = 0;
+        for (size_t i=0; i<group_size; ++i)
+        {
+            bits |= uint32_t(_ctrl[base + i] == b) << i;
+        }
+        return bits;
+#endif
+    }
+
+    // bit i set if control byte i of the group at base is empty or deleted.
+    uint32_t match_free(size_t base) const
+    {
+#ifdef UTILS_CACHE_INDEX_SSE2
+        // full bytes are 0..127, so the sign bit marks empty and deleted.
+        auto ctrl = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(&_ctrl[base])
+        );
+        return uint32_t(_mm_movemask_epi8(ctrl));
+#else
+        uint32_t bits = 0;
+        for (size_t i=0; i<group_size; ++i)
+        {
+            bits |= uint32_t(_ctrl[base + i] < 0) << i;
+        }
+        return bits;
+#endif
+    }
+
+    static size_t lowest_bit(uint32_t bits)
+    {
+#if defined(__GNUC__)
+        return size_t(__builtin_ctz(bits));
+#else
+        size_t i = 0;
+        while (!(bits & 1))
+        {
+            bits >>= 1;
+            ++i;
+        }
+        return i;
+#endif
+    }
+
+    size_t free_position(uint32_t h) const
+    {
+        auto g = h1(h) & _group_mask;
+        for (size_t step = 1; ; g = (g + step++) & _group_mask)
+        {
+            auto bits = match_free(g * group_size);
+            if (bits)
+            {
+                return g * group_size + lowest_bit(bits);
+            }
+        }
+    }
+
+    // drop all tombstones by inserting the live entries afresh.
+    void rebuild()
+    {
+        _rebuild.clear();
+        for (size_t i=0; i<_ctrl.size(); ++i)
+        {
+            if (_ctrl[i] >= 0)
+            {
+                _rebuild.push_back(_entries[i]);
+            }
+            _ctrl[i] = empty;
+        }
+        for (const auto & e : _rebuild)
+        {
+            auto i = free_position(e._hash);
+            _ctrl[i] = h2(e._hash);
+            _entries[i] = e;
+        }
+        _tombstones = 0;
+    }
+
+    size_t _group_mask;
+    std::vector<int8_t> _ctrl;
+    std::vector<entry> _entries;
+
+    size_t _live;
+    size_t _tombstones;
+    // rebuild when live and tombstones reach this.
+    size_t _max_used;
+    // reserved at construction for rebuild.
+    std::vector<entry> _rebuild;
+};
+}
@@ -0,0 +1,253 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      Statistics for cache in C++11.
+//      Hits, misses, insertions, updates, evictions, expirations and
+//      invalidations, and the hit ratio of a sliding window of recent lookups.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils
+{
+
+/*
+Notes:
+1.  Statistics are collected only if CACHE_STATS is defined before including
+    cache.h. Otherwise the counters are an empty class whose calls compile
+    to nothing, and cache::stats() returns a snapshot with enabled == false.
+    Define it the same way in every translation unit, since it changes the
+    layout of cache.
+2.  Counters are relaxed atomics. Lookups by get_shared may run on many
+    threads under a shared lock, so they use atomic increments; all other
+    counting is done under an exclusive lock, by a plain load and store.
+    A snapshot is therefore not an atomic view across counters.
+3.  The window hit ratio samples 1 in 16 lookups into a ring of 8 buckets of
+    1024 samples, so it covers about the last 100K lookups and follows
+    changes in the workload, where hit_ratio() is over the whole lifetime.
+    The bucket turnover is not synchronized with sampling threads, so with
+    get_shared a few samples may be lost; it is a sample anyway.
+*/
+
+//
+// Snapshot returned by cache::stats().
+//
+struct cache_stats
+{
+    bool enabled = false;
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // puts of a new key.
+    uint64_t insertions = 0;
+    // puts of a key already in the cache.
+    uint64_t updates = 0;
+    // items ejected to make room.
+    uint64_t evictions = 0;
+    // items erased because they expired.
+    uint64_t expirations = 0;
+    // items erased because their tag or generation was invalidated.
+    uint64_t invalidations = 0;
+
+    // sampled recent lookups.
+    uint64_t window_hits = 0;
+    uint64_t window_lookups = 0;
+
+    double hit_ratio() const
+    {
+        auto lookups = hits + misses;
+        return lookups ? double(hits) / lookups : 0.0;
+    }
+
+    double window_hit_ratio() const
+    {
+        return window_lookups ? double(window_hits) / window_lookups : 0.0;
+    }
+
+    cache_stats & operator += (const cache_stats & other)
+    {
+        enabled = enabled || other.enabled;
+        hits += other.hits;
+        misses += other.misses;
+        insertions += other.insertions;
+        updates += other.updates;
+        evictions += other.evictions;
+        expirations += other.expirations;
+        invalidations += other.invalidations;
+        window_hits += other.window_hits;
+        window_lookups += other.window_lookups;
+        return *this;
+    }
+};
+
+namespace detail
+{
+
+//
+// Live counters of a cache.
+//
+class cache_counters
+{
+public:
+    void hit(bool shared)
+    {
+        sample(add(_hits, shared), true, shared);
+    }
+
+    void miss(bool shared)
+    {
+        sample(add(_misses, shared), false, shared);
+    }
+
+    void insertion()
+    {
+        add(_insertions, false);
+    }
+
+    void update()
+    {
+        add(_updates, false);
+    }
+
+    void eviction()
+    {
+        add(_evictions, false);
+    }
+
+    void expiration()
+    {
+        add(_expirations, false);
+    }
+
+    void invalidation()
+    {
+        add(_invalidations, false);
+    }
+
+    cache_stats snapshot() const
+    {
+        cache_stats st;
+        st.enabled = true;
+        st.hits = _hits.load(std::memory_order_relaxed);
+        st.misses = _misses.load(std::memory_order_relaxed);
+        st.insertions = _insertions.load(std::memory_order_relaxed);
+        st.updates = _updates.load(std::memory_order_relaxed);
+        st.evictions = _evictions.load(std::memory_order_relaxed);
+        st.expirations = _expirations.load(std::memory_order_relaxed);
+        st.invalidations = _invalidations.load(std::memory_order_relaxed);
+        for (const auto & b : _window)
+        {
+            st.window_hits += b._hits.load(std::memory_order_relaxed);
+            st.window_lookups += b._lookups.load(std::memory_order_relaxed);
+        }
+        return st;
+    }
+
+private:
+    static const uint64_t sample_every = 16;
+    static const size_t window_buckets = 8;
+    static const uint64_t bucket_lookups = 1024;
+
+    struct bucket
+    {
+        std::atomic<uint64_t> _hits{0};
+        std::atomic<uint64_t> _lookups{0};
+    };
+
+    // Return: the count before adding.
+    static uint64_t add(std::atomic<uint64_t> & counter, bool shared)
+    {
+        if (shared)
+        {
+            return counter.fetch_add(1, std::memory_order_relaxed);
+        }
+        // no need for a locked read-modify-write.
+        auto n = counter.load(std::memory_order_relaxed);
+        counter.store(n + 1, std::memory_order_relaxed);
+        return n;
+    }
+
+    void sample(uint64_t count, bool hit, bool shared)
+    {
+        if (count % sample_every)
+        {
+            return;
+        }
+        auto & b = _window[_current.load(std::memory_order_relaxed)];
+        if (hit)
+        {
+            add(b._hits, shared);
+        }
+        if (add(b._lookups, shared) + 1 == bucket_lookups)
+        {
+            // the oldest bucket becomes the current one.
+            auto next =
+                (_current.load(std::memory_order_relaxed) + 1) % window_buckets;
+            _window[next]._hits.store(0, std::memory_order_relaxed);
+            _window[next]._lookups.store(0, std::memory_order_relaxed);
+            _current.store(next, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+    std::atomic<uint64_t> _insertions{0};
+    std::atomic<uint64_t> _updates{0};
+    std::atomic<uint64_t> _evictions{0};
+    std::atomic<uint64_t> _expirations{0};
+    std::atomic<uint64_t> _invalidations{0};
+    bucket _window[window_buckets];
+    std::atomic<size_t> _current{0};
+};
+
+//
+// Stand in for cache_counters when CACHE_STATS is not defined.
+//
+class null_cache_counters
+{
+public:
+    void hit(bool) const
+    {
+    }
+
+    void miss(bool) const
+    {
+    }
+
+    void insertion() const
+    {
+    }
+
+    void update() const
+    {
+    }
+
+    void eviction() const
+    {
+    }
+
+    void expiration() const
+    {
+    }
+
+    void invalidation() const
+    {
+    }
+
+
+    cache_stats snapshot() const
+    {
+        return cache_stats{};
+    }
+};
+
+} // namespace detail
+
+} // namespace utils
@@ -0,0 +1,185 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A cache of byte string values kept compressed, in C++11, on top of
+//      cache. For large compressible values, say JSON or protobufs, it fits
+//      several times more items in the same memory.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "cache.h"
+#include "lz_codec.h"
+
+/*
+Notes:
+1.  Values are std::string. A value at least min_compress bytes long is
+    stored compressed by CODEC, unless that does not make it smaller;
+    shorter values are stored as they are, since compressing them saves
+    little and costs a pass over the codec. A stored value starts with a
+    byte telling which.
+2.  The memory budget, max_bytes, bounds the total stored size of the
+    values, through the weigher of cache. So the better values compress,
+    the more of them fit. It does not count the fixed memory of a slot and
+    of its std::string. A slot does not keep the buffer of a value it held
+    before (see Weight in cache.h), so the memory held follows the budget
+    even after large values are replaced by small ones. capacity still
+    bounds the number of items.
+3.  get decompresses into the string given, reusing its memory, so a caller
+    that keeps the string across gets does not allocate once it is large
+    enough.
+4.  CODEC has
+        static void compress(const char * data, size_t size, std::string & out);
+        static bool decompress(const char * data, size_t size, std::string & out);
+    out is replaced by the result, and decompress returns false on invalid
+    input. lz_codec is the default; see lz_codec.h.
+5.  Not thread safe, like cache.
+*/
+namespace utils
+{
+
+template<
+    typename KEY,
+    typename POLICY = lru_policy, typename CODEC = lz_codec,
+    typename HASH = std::hash<KEY>, typename KEYEQ = std::equal_to<KEY>
+>
+class compressed_cache
+{
+    using cache_type = cache<KEY, std::string, POLICY, flat_index, HASH, KEYEQ>;
+
+public:
+    using clock = typename cache_type::clock;
+
+    // Params:
+    //        capacity: maximum number of items.
+    //        max_bytes: maximum total stored size of the values.
+    //        min_compress: values shorter than this are not compressed.
+    compressed_cache(size_t capacity, size_t max_bytes, size_t min_compress = 128) :
+        _cache(
+            capacity, max_bytes,
+            [](const KEY &, const std::string & stored){ return stored.size(); }
+        ),
+        _min_compress(min_compress)
+    {
+    }
+
+    // if found in cache, copies the value to val and return true.
+    bool get(const KEY & key, std::string & val)
+    {
+        auto p = _cache.get(key);
+        if (!p)
+        {
+            return false;
+        }
+        if (!decode(*p, val))
+        {
+            _cache.erase(key);
+            return false;
+        }
+        return true;
+    }
+
+    // Return: true if key is in the cache. Not a use of the item.
+    bool contains(const KEY & key) const
+    {
+        return _cache.contains(key);
+    }
+
+    // put an item that never expires.
+    // Return: false if the item was rejected as heavier than max bytes.
+    bool put(const KEY & key, const std::string & val)
+    {
+        encode(val);
+        return _cache.put(key, _stored);
+    }
+
+    // put an item that expires ttl from now.
+    bool put(const KEY & key, const std::string & val, typename clock::duration ttl)
+    {
+        encode(val);
+        return _cache.put(key, _stored, ttl);
+    }
+
+    // Return: true if key was in the cache.
+    bool erase(const KEY & key)
+    {
+        return _cache.erase(key);
+    }
+
+    size_t size()
+    {
+        return _cache.size();
+    }
+
+    size_t capacity()
+    {
+        return _cache.capacity();
+    }
+
+    // Return: total stored size of the values.
+    size_t stored_bytes()
+    {
+        return _cache.weight();
+    }
+
+    size_t max_bytes()
+    {
+        return _cache.max_weight();
+    }
+
+    cache_stats stats() const
+    {
+        return _cache.stats();
+    }
+
+    bool check_consistency(std::string & details)
+    {
+        return _cache.check_consistency(details);
+    }
+
+private:
+    // first byte of a stored value.
+    static const char raw = 'r';
+    static const char compressed = 'z';
+
+    // encode val into _stored.
+    void encode(const std::string & val)
+    {
+        if (val.size() >= _min_compress)
+        {
+            CODEC::compress(val.data(), val.size(), _scratch);
+            if (_scratch.size() + 1 < val.size())
+            {
+                _stored.assign(1, compressed);
+                _stored += _scratch;
+                return;
+            }
+        }
+        _stored.assign(1, raw);
+        _stored += val;
+    }
+
+    static bool decode(const std::string & stored, std::string & val)
+    {
+        if (stored[0] == raw)
+        {
+            val.assign(stored, 1, std::string::npos);
+            return true;
+        }
+        return CODEC::decompress(stored.data() + 1, stored.size() - 1, val);
+    }
+
+    cache_type _cache;
+    size_t _min_compress;
+    // reused across puts, so encoding does not allocate each time.
+    std::string _scratch;
+    std::string _stored;
+};
+}
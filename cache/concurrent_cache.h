@@ -0,0 +1,621 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A thread safe cache in C++11 on top of cache.
+//      Keys are hashed into shards, each an independently locked cache, so
+//      threads working on different shards do not contend.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#if __cplusplus >= 201703L
+#include <shared_mutex>
+#endif
+
+#include "cache.h"
+
+namespace utils
+{
+
+/*
+Notes:
+1.  Each shard gets an equal share of the capacity, rounded up. LRU ejection
+    is per shard, so the entry ejected is the least recently used of its
+    shard, not necessarily of the whole cache.
+2.  Use a number of shards a few times the number of threads using the
+    cache, so that two threads rarely hit the same shard at the same time.
+3.  The shard is picked from the high bits of the mixed key hash, so the
+    choice is independent of the bucket chosen inside the shard.
+4.  max weight is also shared equally, so an item heavier than the share
+    of its shard is rejected even if it is lighter than max weight.
+5.  With a policy that has concurrent_hits, like clock_policy, and C++17,
+    get takes a shared lock on the shard, so readers of the same shard run
+    in parallel. Otherwise every operation takes the shard lock exclusively.
+    Hits and misses are counted by the cache of the shard, only if
+    CACHE_STATS is defined, so without it a shared get writes nothing but
+    the lock and the policy's bit of the item.
+6.  Values are stored as shared_ptr<const VAL>, so get can hand out the
+    stored value without copying it, and the handle stays valid after the
+    item is ejected. The cost is an allocation per put.
+7.  get_or_load is single flight: concurrent misses on a key wait on one
+    call of the loader, through a shared_future in a per shard map of keys
+    being loaded. The loaded value is put and the key leaves the map under
+    the same lock, so a caller sees either the load in flight or its value.
+    An exception from the loader reaches all the waiting callers, and
+    nothing is cached.
+8.  multi_get and multi_put sort the keys of a batch by shard and take the
+    lock of each shard once for all its keys, then look them up with the
+    batched, prefetching multi_get and multi_put of cache.
+*/
+
+template<
+    typename KEY, typename VAL,
+    typename POLICY = lru_policy, typename HASH = std::hash<KEY>,
+    typename KEYEQ = std::equal_to<KEY>
+>
+class concurrent_cache
+{
+    using handle = std::shared_ptr<const VAL>;
+    using cache_type = cache<KEY, handle, POLICY, flat_index, HASH, KEYEQ>;
+
+    // K if lookups by K are enabled, that is if HASH and KEYEQ are
+    // transparent; see cache.
+    template<typename K>
+    using transparent_key = typename std::enable_if<
+        detail::is_transparent<HASH>::value
+            && detail::is_transparent<KEYEQ>::value,
+        K
+    >::type;
+
+public:
+    // the counters of cache_stats only if CACHE_STATS is defined; see
+    // cache_stats.h. size, capacity and weight always.
+    struct stats : cache_stats
+    {
+        size_t size = 0;
+        size_t capacity = 0;
+        size_t weight = 0;
+    };
+
+    using clock = typename cache_type::clock;
+    using weigher_type = std::function<size_t(const KEY &, const VAL &)>;
+
+    concurrent_cache(size_t capacity = 1024, size_t num_shards = 16) :
+        concurrent_cache(
+            capacity, std::numeric_limits<size_t>::max(), weigher_type{},
+            num_shards
+        )
+    {
+    }
+
+    // Params:
+    //        capacity: maximum number of items.
+    //        max_weight: maximum total weight of items; see cache.
+    //        weigher: weight of an item, say its size in bytes.
+    //        num_shards: number of independently locked shards.
+    concurrent_cache(
+        size_t capacity, size_t max_weight, weigher_type weigher,
+        size_t num_shards = 16
+    )
+    {
+        num_shards = std::max(num_shards, size_t{1});
+        auto shard_capacity = (capacity + num_shards - 1) / num_shards;
+        auto shard_weight = (max_weight == std::numeric_limits<size_t>::max())
+            ? max_weight : (max_weight + num_shards - 1) / num_shards;
+        _shards.reserve(num_shards);
+        for (size_t i=0; i<num_shards; ++i)
+        {
+            _shards.emplace_back(
+                new shard{shard_capacity, shard_weight, handle_weigher(weigher)}
+            );
+        }
+    }
+
+    // if found in cache, copies to val and return true.
+    bool get(const KEY & key, VAL & val)
+    {
+        return copy(find(key), val);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    bool get(const K & key, VAL & val)
+    {
+        return copy(find(key), val);
+    }
+
+    // Return: the cached value without copying it, or nullptr if not found.
+    std::shared_ptr<const VAL> get(const KEY & key)
+    {
+        return find(key);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    std::shared_ptr<const VAL> get(const K & key)
+    {
+        return find(key);
+    }
+
+    // get a batch of keys, taking the lock of each shard once.
+    // Params:
+    //        keys: keys to look up.
+    //        vals: OUT the value of each key, nullptr if not found.
+    // Return: number of keys found.
+    size_t multi_get(
+        const std::vector<KEY> & keys, std::vector<std::shared_ptr<const VAL>> & vals
+    )
+    {
+        vals.assign(keys.size(), nullptr);
+        std::vector<uint32_t> order;
+        std::vector<size_t> bounds;
+        group_by_shard(keys, [](const KEY & k) -> const KEY & { return k; }, order, bounds);
+        std::vector<std::reference_wrapper<const KEY>> batch;
+        std::vector<const handle *> found;
+        size_t hits = 0;
+        for (size_t i=0; i<_shards.size(); ++i)
+        {
+            auto begin = bounds[i], end = bounds[i + 1];
+            if (begin == end)
+            {
+                continue;
+            }
+            batch.clear();
+            for (auto j=begin; j<end; ++j)
+            {
+                batch.push_back(std::cref(keys[order[j]]));
+            }
+            found.resize(end - begin);
+            auto & s = *_shards[i];
+            size_t n;
+            {
+                read_lock l{s._mutex};
+                n = lookup_batch(
+                    s, batch, found.data(), std::integral_constant<bool, shared_reads>{}
+                );
+                // copy the handles before another thread can eject them.
+                for (auto j=begin; j<end; ++j)
+                {
+                    if (found[j - begin])
+                    {
+                        vals[order[j]] = *found[j - begin];
+                    }
+                }
+            }
+            hits += n;
+        }
+        return hits;
+    }
+
+    // Return: true if key is in the cache and not expired.
+    bool contains(const KEY & key)
+    {
+        return contains_key(key);
+    }
+
+    template<typename K, typename = transparent_key<K>>
+    bool contains(const K & key)
+    {
+        return contains_key(key);
+    }
+
+    // Return: the cached value, or if not found the value of loader(key)
+    //         which is then put. Concurrent misses on key share one call of
+    //         loader. Rethrows an exception from loader.
+    template<typename LOADER>
+    std::shared_ptr<const VAL> get_or_load(const KEY & key, LOADER && loader)
+    {
+        return load_once(
+            key, loader,
+            [](cache_type & c, const KEY & k, const handle & v){ c.put(k, v); }
+        );
+    }
+
+    // Same as get_or_load, and the loaded value expires ttl after the load.
+    template<typename LOADER>
+    std::shared_ptr<const VAL> get_or_load(
+        const KEY & key, LOADER && loader, typename clock::duration ttl
+    )
+    {
+        return load_once(
+            key, loader,
+            [ttl](cache_type & c, const KEY & k, const handle & v){ c.put(k, v, ttl); }
+        );
+    }
+
+    // Return: false if the item was rejected as heavier than max weight.
+    bool put(const KEY & key, const VAL & val)
+    {
+        auto v = std::make_shared<const VAL>(val);
+        auto & s = shard_for(key);
+        write_lock l{s._mutex};
+        return s._cache.put(key, v);
+    }
+
+    // put an item that expires ttl from now.
+    // Return: false if the item was rejected as heavier than max weight.
+    bool put(const KEY & key, const VAL & val, typename clock::duration ttl)
+    {
+        auto v = std::make_shared<const VAL>(val);
+        auto & s = shard_for(key);
+        write_lock l{s._mutex};
+        return s._cache.put(key, v, ttl);
+    }
+
+    // put a batch of items, taking the lock of each shard once.
+    // Return: number of items put, that is not rejected as too heavy.
+    size_t multi_put(const std::vector<std::pair<KEY, VAL>> & items)
+    {
+        return put_batch(
+            items,
+            [](cache_type & c, const std::vector<shard_item> & b){
+                return c.multi_put(b.begin(), b.end());
+            }
+        );
+    }
+
+    // put a batch of items that expire ttl from now.
+    size_t multi_put(
+        const std::vector<std::pair<KEY, VAL>> & items,
+        typename clock::duration ttl
+    )
+    {
+        return put_batch(
+            items,
+            [ttl](cache_type & c, const std::vector<shard_item> & b){
+                return c.multi_put(b.begin(), b.end(), ttl);
+            }
+        );
+    }
+
+    // Return: true if key was in the cache.
+    bool erase(const KEY & key)
+    {
+        auto & s = shard_for(key);
+        write_lock l{s._mutex};
+        return s._cache.erase(key);
+    }
+
+    // erase the expired items of all shards.
+    void expire()
+    {
+        for (auto & s : _shards)
+        {
+            write_lock l{s->_mutex};
+            s->_cache.expire();
+        }
+    }
+
+    size_t size()
+    {
+        size_t n = 0;
+        for (auto & s : _shards)
+        {
+            write_lock l{s->_mutex};
+            n += s->_cache.size();
+        }
+        return n;
+    }
+
+    size_t capacity()
+    {
+        size_t n = 0;
+        for (auto & s : _shards)
+        {
+            write_lock l{s->_mutex};
+            n += s->_cache.capacity();
+        }
+        return n;
+    }
+
+    inline size_t num_shards() const
+    {
+        return _shards.size();
+    }
+
+    // stats of each shard.
+    std::vector<stats> shard_stats()
+    {
+        std::vector<stats> ret;
+        ret.reserve(_shards.size());
+        for (auto & s : _shards)
+        {
+            write_lock l{s->_mutex};
+            stats st;
+            static_cast<cache_stats &>(st) = s->_cache.stats();
+            st.size = s->_cache.size();
+            st.capacity = s->_cache.capacity();
+            st.weight = s->_cache.weight();
+            ret.push_back(st);
+        }
+        return ret;
+    }
+
+    // stats of all shards added up.
+    stats get_stats()
+    {
+        stats total;
+        for (const auto & st : shard_stats())
+        {
+            total += st;
+            total.size += st.size;
+            total.capacity += st.capacity;
+            total.weight += st.weight;
+        }
+        return total;
+    }
+
+    // check the consistency of internal data structures of all shards.
+    // Params:
+    //        details: OUT returns the detailed consistency check results.
+    // Return: true if ok.
+    bool check_consistency(std::string & details)
+    {
+        bool ret = true;
+        std::ostringstream oss;
+        for (size_t i=0; i<_shards.size(); ++i)
+        {
+            write_lock l{_shards[i]->_mutex};
+            std::string shard_details;
+            ret = _shards[i]->_cache.check_consistency(shard_details) && ret;
+            oss << " shard" << i << ":[" << shard_details << " ]";
+        }
+        details = oss.str();
+        return ret;
+    }
+
+    // No copy construction or assignment.
+    concurrent_cache(const concurrent_cache &) = delete;
+    concurrent_cache & operator=(const concurrent_cache &) = delete;
+
+private:
+#if __cplusplus >= 201703L
+    static const bool shared_reads = POLICY::concurrent_hits;
+    using mutex_type = typename std::conditional<
+        shared_reads, std::shared_mutex, std::mutex
+    >::type;
+    using read_lock = typename std::conditional<
+        shared_reads,
+        std::shared_lock<mutex_type>, std::unique_lock<mutex_type>
+    >::type;
+#else
+    static const bool shared_reads = false;
+    using mutex_type = std::mutex;
+    using read_lock = std::unique_lock<mutex_type>;
+#endif
+    using write_lock = std::unique_lock<mutex_type>;
+
+    using load = std::shared_future<handle>;
+    // an item of a batch put, referring to the key of the caller.
+    using shard_item = std::pair<std::reference_wrapper<const KEY>, handle>;
+
+    struct shard
+    {
+        shard(
+            size_t capacity, size_t max_weight,
+            const typename cache_type::weigher_type & weigher
+        ) :
+            _cache(capacity, max_weight, weigher)
+        {
+        }
+
+        mutex_type _mutex;
+        cache_type _cache;
+        // keys being loaded by get_or_load.
+        std::unordered_map<KEY, load, HASH, KEYEQ> _loading;
+    };
+
+    static typename cache_type::weigher_type
+    handle_weigher(weigher_type weigher)
+    {
+        if (!weigher)
+        {
+            return nullptr;
+        }
+        return [weigher](const KEY & key, const handle & val){
+            return weigher(key, *val);
+        };
+    }
+
+    template<typename K>
+    handle find(const K & key)
+    {
+        auto & s = shard_for(key);
+        read_lock l{s._mutex};
+        auto p = lookup(s, key, std::integral_constant<bool, shared_reads>{});
+        return p ? *p : nullptr;
+    }
+
+    template<typename K>
+    static const handle * lookup(shard & s, const K & key, std::true_type)
+    {
+        return s._cache.get_shared(key);
+    }
+
+    template<typename K>
+    static const handle * lookup(shard & s, const K & key, std::false_type)
+    {
+        return s._cache.get(key);
+    }
+
+    template<typename BATCH>
+    static size_t lookup_batch(
+        shard & s, const BATCH & batch, const handle ** found, std::true_type
+    )
+    {
+        return s._cache.multi_get_shared(batch.begin(), batch.end(), found);
+    }
+
+    template<typename BATCH>
+    static size_t lookup_batch(
+        shard & s, const BATCH & batch, const handle ** found, std::false_type
+    )
+    {
+        return s._cache.multi_get(batch.begin(), batch.end(), found);
+    }
+
+    template<typename PUT>
+    size_t put_batch(const std::vector<std::pair<KEY, VAL>> & items, PUT put)
+    {
+        std::vector<uint32_t> order;
+        std::vector<size_t> bounds;
+        group_by_shard(
+            items,
+            [](const std::pair<KEY, VAL> & item) -> const KEY & { return item.first; },
+            order, bounds
+        );
+        std::vector<shard_item> batch;
+        size_t done = 0;
+        for (size_t i=0; i<_shards.size(); ++i)
+        {
+            auto begin = bounds[i], end = bounds[i + 1];
+            if (begin == end)
+            {
+                continue;
+            }
+            // allocate the values outside the lock.
+            batch.clear();
+            for (auto j=begin; j<end; ++j)
+            {
+                const auto & item = items[order[j]];
+                batch.emplace_back(
+                    std::cref(item.first), std::make_shared<const VAL>(item.second)
+                );
+            }
+            auto & s = *_shards[i];
+            write_lock l{s._mutex};
+            done += put(s._cache, batch);
+        }
+        return done;
+    }
+
+    // sort the indices of items by shard, keeping their order within a
+    // shard. The items of shard i are order[bounds[i]] to
+    // order[bounds[i + 1] - 1].
+    template<typename ITEMS, typename KEY_OF>
+    void group_by_shard(
+        const ITEMS & items, KEY_OF key_of,
+        std::vector<uint32_t> & order, std::vector<size_t> & bounds
+    )
+    {
+        std::vector<uint32_t> shard_of(items.size());
+        bounds.assign(_shards.size() + 1, 0);
+        for (size_t j=0; j<items.size(); ++j)
+        {
+            shard_of[j] = uint32_t(shard_index(key_of(items[j])));
+            ++bounds[shard_of[j] + 1];
+        }
+        for (size_t i=0; i<_shards.size(); ++i)
+        {
+            bounds[i + 1] += bounds[i];
+        }
+        order.resize(items.size());
+        auto next = bounds;
+        for (size_t j=0; j<items.size(); ++j)
+        {
+            order[next[shard_of[j]]++] = uint32_t(j);
+        }
+    }
+
+    template<typename K>
+    bool contains_key(const K & key)
+    {
+        auto & s = shard_for(key);
+        read_lock l{s._mutex};
+        return s._cache.contains(key);
+    }
+
+    static bool copy(const handle & p, VAL & val)
+    {
+        if (p)
+        {
+            val = *p;
+        }
+        return p != nullptr;
+    }
+
+    template<typename LOADER, typename PUT>
+    handle load_once(const KEY & key, LOADER & loader, PUT put)
+    {
+        auto found = get(key);
+        if (found)
+        {
+            return found;
+        }
+
+        auto & s = shard_for(key);
+        std::promise<handle> promise;
+        {
+            write_lock l{s._mutex};
+            // loaded while this thread waited for the lock; peek, since
+            // the get above already counted this lookup.
+            auto p = s._cache.peek(key);
+            if (p)
+            {
+                return *p;
+            }
+            auto itr = s._loading.find(key);
+            if (itr != s._loading.end())
+            {
+                auto pending = itr->second;
+                l.unlock();
+                return pending.get();
+            }
+            s._loading.emplace(key, promise.get_future().share());
+        }
+
+        // this thread loads; the others wait on its promise.
+        try
+        {
+            auto v = std::make_shared<const VAL>(loader(key));
+            {
+                write_lock l{s._mutex};
+                put(s._cache, key, v);
+                s._loading.erase(key);
+            }
+            promise.set_value(v);
+            return v;
+        }
+        catch (...)
+        {
+            {
+                write_lock l{s._mutex};
+                s._loading.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    template<typename K>
+    shard & shard_for(const K & key)
+    {
+        return *_shards[shard_index(key)];
+    }
+
+    template<typename K>
+    size_t shard_index(const K & key) const
+    {
+        // Fibonacci hashing; the high bits are the well mixed ones.
+        auto h = uint64_t(HASH{}(key)) * 0x9E3779B97F4A7C15ull;
+        return size_t((h >> 32) % _shards.size());
+    }
+
+    std::vector<std::unique_ptr<shard>> _shards;
+};
+}
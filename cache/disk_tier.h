@@ -0,0 +1,392 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A log structured on disk store of trivially copyable keys and values
+//      in C++11, as the second tier of a cache.
+//      Items are appended to a file and read back through a memory mapping;
+//      the file is compacted in the background.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+
+/*
+Notes:
+1.  The file is a log of fixed size records {KEY bytes, VAL bytes}, numbered
+    from 0. An in memory index maps each key to the number of its latest
+    record; earlier records of the key are garbage.
+2.  Appends collect in a write buffer that is written to the file when
+    full, so the file grows by large sequential writes. A read of a record
+    still in the buffer is served from it; others are read through a
+    mapping of the file, mapped again when a read goes past its end.
+3.  Past capacity, put drops the oldest items, in log order. So the tier
+    keeps the items most recently put, which for a cache tier are the ones
+    most recently evicted from memory.
+4.  Once the garbage is as much as the live records, and at least
+    min_garbage records, a background thread compacts the file: it copies
+    the live records to a new file without holding the lock, then under
+    the lock copies what was appended meanwhile, repoints the index and
+    renames the new file over the old. Gets and puts go on during the copy.
+5.  The file is a spill area, not a store: it is truncated at construction
+    and removed at destruction. Its format is the memory layout of KEY and
+    VAL.
+6.  Thread safe; every operation takes one mutex.
+7.  If the file cannot be opened, or a write to it fails, say when the disk
+    is full, the tier fails: it forgets its items and ignores later puts, so
+    every get is a miss, and is_open() turns false. A read of a record the
+    mapping does not cover is a miss too, and never reads past the mapping.
+*/
+namespace utils
+{
+
+template<
+    typename KEY, typename VAL,
+    typename HASH = std::hash<KEY>, typename KEYEQ = std::equal_to<KEY>
+>
+class disk_tier
+{
+    static_assert(
+        std::is_trivially_copyable<KEY>::value
+            && std::is_trivially_copyable<VAL>::value,
+        "disk_tier needs trivially copyable KEY and VAL"
+    );
+
+public:
+    static const size_t record_size = sizeof(KEY) + sizeof(VAL);
+    static const size_t min_garbage = 1024;
+
+    // Params:
+    //        path: file to spill to.
+    //        capacity: maximum number of items.
+    //        buffer_records: records buffered before a write to the file.
+    disk_tier(const std::string & path, size_t capacity, size_t buffer_records = 4096) :
+        _path(path),
+        _capacity(capacity),
+        _buffer_records(std::max(buffer_records, size_t{1})),
+        _out(path, std::ios::binary | std::ios::trunc),
+        _flushed(0),
+        _head(0),
+        _end(0),
+        _compactions(0),
+        _compacting(false),
+        _failed(!_out)
+    {
+        _buffer.reserve(_buffer_records * record_size);
+    }
+
+    ~disk_tier()
+    {
+        if (_compactor.joinable())
+        {
+            _compactor.join();
+        }
+        _out.close();
+        _map.reset();
+        std::remove(_path.c_str());
+    }
+
+    // Return: false if the file could not be opened or written; see note 7.
+    bool is_open() const
+    {
+        return !_failed;
+    }
+
+    void put(const KEY & key, const VAL & val)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        if (_capacity == 0 || _failed)
+        {
+            return;
+        }
+        append(key, val);
+        while (_index.size() > _capacity)
+        {
+            drop_oldest();
+        }
+        auto garbage = _end - _index.size();
+        if (!_compacting && !_failed
+            && garbage >= std::max(_index.size(), size_t(min_garbage)))
+        {
+            if (_compactor.joinable())
+            {
+                _compactor.join();
+            }
+            _compacting = true;
+            _compactor = std::thread([this](){
+                compact();
+                _compacting = false;
+            });
+        }
+    }
+
+    // if found, copies to val and return true.
+    bool get(const KEY & key, VAL & val)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        auto itr = _index.find(key);
+        if (itr == _index.end())
+        {
+            return false;
+        }
+        auto r = record(itr->second);
+        if (!r)
+        {
+            return false;
+        }
+        std::memcpy(&val, r + sizeof(KEY), sizeof(VAL));
+        return true;
+    }
+
+    // Return: true if key was found.
+    bool erase(const KEY & key)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _index.erase(key) > 0;
+    }
+
+    // Return: number of items.
+    size_t size()
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _index.size();
+    }
+
+    inline size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    // Return: number of records in the log, live or garbage.
+    size_t records()
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _end - _head;
+    }
+
+    size_t compactions() const
+    {
+        return _compactions.load(std::memory_order_relaxed);
+    }
+
+    // compact the file now, in this thread.
+    void compact()
+    {
+        std::lock_guard<std::mutex> c{_compact_mutex};
+        std::unique_lock<std::mutex> l{_mutex};
+        flush();
+        if (_failed)
+        {
+            return;
+        }
+        auto old_end = _end;
+        // live records in log order, so the new file keeps the age order.
+        std::vector<uint64_t> numbers;
+        numbers.reserve(_index.size());
+        for (const auto & kv : _index)
+        {
+            numbers.push_back(kv.second);
+        }
+        std::sort(numbers.begin(), numbers.end());
+        auto map = mapping(old_end);
+        if (!covers(*map, old_end))
+        {
+            return;
+        }
+        l.unlock();
+
+        // copy without the lock; records up to old_end never change.
+        auto temp = _path + ".compact";
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        for (auto n : numbers)
+        {
+            out.write(map->data() + n * record_size, record_size);
+        }
+
+        l.lock();
+        flush();
+        map = mapping(_end);
+        if (_failed || !covers(*map, _end))
+        {
+            std::remove(temp.c_str());
+            return;
+        }
+        uint64_t next = numbers.size();
+        // append what was put during the copy.
+        for (auto n = old_end; n < _end; ++n)
+        {
+            out.write(map->data() + n * record_size, record_size);
+        }
+        out.close();
+        if (!out || std::rename(temp.c_str(), _path.c_str()) != 0)
+        {
+            std::remove(temp.c_str());
+            return;
+        }
+        // repoint the keys whose latest record was copied.
+        for (auto & kv : _index)
+        {
+            if (kv.second >= old_end)
+            {
+                kv.second = next + (kv.second - old_end);
+            }
+            else
+            {
+                auto itr = std::lower_bound(numbers.begin(), numbers.end(), kv.second);
+                kv.second = uint64_t(itr - numbers.begin());
+            }
+        }
+        _end = next + (_end - old_end);
+        _flushed = _end;
+        _head = 0;
+        _out.close();
+        _out.open(_path, std::ios::binary | std::ios::app);
+        _map.reset();
+        if (!_out)
+        {
+            fail();
+        }
+        _compactions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // No copy construction or assignment.
+    disk_tier(const disk_tier &) = delete;
+    disk_tier & operator=(const disk_tier &) = delete;
+
+private:
+    void append(const KEY & key, const VAL & val)
+    {
+        auto size = _buffer.size();
+        _buffer.resize(size + record_size);
+        std::memcpy(&_buffer[size], &key, sizeof(KEY));
+        std::memcpy(&_buffer[size + sizeof(KEY)], &val, sizeof(VAL));
+        _index[key] = _end++;
+        if (_buffer.size() >= _buffer_records * record_size)
+        {
+            flush();
+        }
+    }
+
+    // write the buffer to the file.
+    void flush()
+    {
+        if (_buffer.empty())
+        {
+            return;
+        }
+        if (!_out.write(_buffer.data(), _buffer.size()) || !_out.flush())
+        {
+            fail();
+            return;
+        }
+        _flushed = _end;
+        _buffer.clear();
+    }
+
+    // forget all items and take no more; see note 7.
+    void fail()
+    {
+        _failed = true;
+        _index.clear();
+        _buffer.clear();
+        _head = _end;
+        _flushed = _end;
+    }
+
+    // Return: true if map holds the first records.
+    static bool covers(const mapped_file & map, uint64_t records)
+    {
+        return records == 0
+            || (map.is_open() && map.size() >= records * record_size);
+    }
+
+    // Return: a mapping of the file covering the first records.
+    std::shared_ptr<mapped_file> mapping(uint64_t records)
+    {
+        if (!_map || _map->size() < records * record_size)
+        {
+            _map = std::make_shared<mapped_file>(_path, mapped_file::access::random);
+        }
+        return _map;
+    }
+
+    // Return: the bytes of record n, or nullptr if it cannot be read.
+    const char * record(uint64_t n)
+    {
+        if (n >= _flushed)
+        {
+            return &_buffer[(n - _flushed) * record_size];
+        }
+        auto map = mapping(n + 1);
+        return covers(*map, n + 1) ? map->data() + n * record_size : nullptr;
+    }
+
+    // forget the oldest live item.
+    void drop_oldest()
+    {
+        for (;;)
+        {
+            auto n = _head++;
+            auto r = record(n);
+            if (!r)
+            {
+                // cannot tell which key it is; give up on the file.
+                fail();
+                return;
+            }
+            // raw storage, since KEY need not be default constructible.
+            typename std::aligned_storage<sizeof(KEY), alignof(KEY)>::type k;
+            std::memcpy(&k, r, sizeof(KEY));
+            auto itr = _index.find(*reinterpret_cast<const KEY *>(&k));
+            if (itr != _index.end() && itr->second == n)
+            {
+                _index.erase(itr);
+                return;
+            }
+        }
+    }
+
+    std::string _path;
+    size_t _capacity;
+    size_t _buffer_records;
+
+    std::mutex _mutex;
+    std::ofstream _out;
+    std::vector<char> _buffer;
+    // records in the file; the rest are in the buffer.
+    uint64_t _flushed;
+    // records before _head are all garbage.
+    uint64_t _head;
+    uint64_t _end;
+    std::unordered_map<KEY, uint64_t, HASH, KEYEQ> _index;
+    // shared with a compaction copying from it.
+    std::shared_ptr<mapped_file> _map;
+
+    std::mutex _compact_mutex;
+    std::atomic<size_t> _compactions;
+    std::atomic<bool> _compacting;
+    std::thread _compactor;
+    // see note 7.
+    std::atomic<bool> _failed;
+};
+}
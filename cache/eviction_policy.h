@@ -0,0 +1,747 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      Eviction policies for cache in C++11.
+//      A policy decides which cached item is ejected when the cache is full.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "cache_index.h"
+
+/*
+Notes:
+A policy is a template parameter of cache. It tracks slots of the cache by
+their 32 bit slot index, in arrays of its own sized to capacity at
+construction. It has the interface
+    POLICY(size_t capacity)
+    void on_insert(uint32_t slot, uint64_t hash)
+        a new item was put in slot. hash is the hash of its key.
+    void on_hit(uint32_t slot)
+        the item in slot was read.
+    void on_miss(uint64_t hash)
+        a key with hash was looked up and not found. Most policies ignore
+        it. Must be const for a policy with concurrent_hits.
+    void on_erase(uint32_t slot)
+        the item in slot was removed from the cache.
+    uint32_t victim(uint64_t hash)
+        slot of the item to eject to make room for a new item whose key has
+        hash. Called when the cache is full, or over its max weight, so
+        with at least one slot in use. The policy must not forget the slot
+        yet; the cache calls on_erase for it next.
+    template<typename FN> void for_each(FN fn) const
+        calls fn(slot) for every slot, in the order they would be ejected
+        (approximate for policies that do not keep an order).
+    static const bool concurrent_hits
+        true if on_hit and on_miss are const and safe to call from many
+        threads at the same time. Then cache::get_shared can be used under a
+        shared lock.
+
+lru_policy:
+    a doubly linked list of slots by 32 bit indices, least recently used at
+    the head. A hit moves the slot to the tail, so reads write the list.
+
+clock_policy:
+    one reference bit per slot and a hand that sweeps the slots in a ring.
+    A hit only sets the reference bit with a relaxed atomic store, so
+    concurrent readers do not write shared structure. To find a victim the
+    hand clears set bits as it passes and stops at the first clear bit.
+    The hit ratio is close to lru for most workloads.
+
+slru_policy:
+    segmented lru. New items enter a probation lru list; a hit in probation
+    promotes the item to a protected lru list, at most 80% of capacity, whose
+    overflow goes back to probation. Victims come from probation first, so
+    items read only once are ejected before items read again.
+
+two_q_policy:
+    the full 2Q. New items enter A1in, a fifo of 25% of capacity, and hits
+    there do not reorder it. Items ejected from A1in leave their hash in
+    A1out, a ghost fifo of hashes half the capacity long. A new item whose
+    hash is in A1out was seen again soon after it left, so it goes straight
+    to Am, an lru list for the rest. Scans pass through A1in without
+    touching Am.
+
+arc_policy:
+    adaptive replacement cache. T1 is an lru list of items seen once
+    recently, T2 of items seen at least twice; B1 and B2 are ghost lists of
+    the hashes last ejected from T1 and T2. A new item whose hash is in B1
+    (B2) shows T1 (T2) is too small, so the target size p of T1 grows
+    (shrinks), and the item goes to T2. The victim is the lru of T1 if T1 is
+    over p, else the lru of T2. The ghost lists only fill once items are
+    ejected, so p adapts only while the cache is full.
+
+lfu_policy:
+    least frequently used in O(1). Slots are in buckets of equal hit count,
+    themselves in a list by increasing count. A hit moves the slot to the
+    bucket of the next count, creating it next to the current one if needed.
+    The victim is the least recently used slot of the first bucket. Counts
+    never age, so it suits workloads whose popular keys do not change.
+
+Ghost lists hold 64 bit hashes, not keys, in arrays sized at construction,
+so they never allocate. A hash collision only costs a wrong guess of
+recency.
+
+tinylfu_policy is in tinylfu_policy.h.
+*/
+namespace utils
+{
+
+namespace detail
+{
+
+//
+// Doubly linked lists of slots by 32 bit slot index, all sharing one array
+// of links sized to capacity. A slot is in at most one list at a time.
+//
+class slot_lists
+{
+public:
+    static const uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    struct list
+    {
+        uint32_t _head = npos;
+        uint32_t _tail = npos;
+        size_t _size = 0;
+    };
+
+    explicit slot_lists(size_t capacity) : _links(capacity, link{npos, npos})
+    {
+    }
+
+    void push_back(list & l, uint32_t s)
+    {
+        auto & k = _links[s];
+        k._prev = l._tail;
+        k._next = npos;
+        (l._tail == npos ? l._head : _links[l._tail]._next) = s;
+        l._tail = s;
+        ++l._size;
+    }
+
+    void remove(list & l, uint32_t s)
+    {
+        auto & k = _links[s];
+        (k._prev == npos ? l._head : _links[k._prev]._next) = k._next;
+        (k._next == npos ? l._tail : _links[k._next]._prev) = k._prev;
+        --l._size;
+    }
+
+    void move_to_back(list & l, uint32_t s)
+    {
+        remove(l, s);
+        push_back(l, s);
+    }
+
+    template<typename FN>
+    void for_each(const list & l, FN && fn) const
+    {
+        for (auto s = l._head; s != npos; s = _links[s]._next)
+        {
+            fn(s);
+        }
+    }
+
+private:
+    struct link
+    {
+        uint32_t _prev;
+        uint32_t _next;
+    };
+
+    std::vector<link> _links;
+};
+
+//
+// A bounded fifo of key hashes that remembers recently ejected keys.
+// Pushing to a full ghost list drops its oldest hash.
+//
+class ghost_list
+{
+public:
+    explicit ghost_list(size_t capacity) :
+        _capacity(capacity),
+        _lists(capacity),
+        _hashes(capacity, 0),
+        _lookup(capacity)
+    {
+        _free.reserve(capacity);
+        for (size_t i=capacity; i>0; --i)
+        {
+            _free.push_back(uint32_t(i - 1));
+        }
+    }
+
+    inline size_t size() const
+    {
+        return _fifo._size;
+    }
+
+    bool contains(uint64_t hash) const
+    {
+        return find(hash) != flat_index::npos;
+    }
+
+    // Return: true if hash was in the list.
+    bool erase(uint64_t hash)
+    {
+        auto g = find(hash);
+        if (g == flat_index::npos)
+        {
+            return false;
+        }
+        remove(g);
+        return true;
+    }
+
+    void push_back(uint64_t hash)
+    {
+        if (_capacity == 0 || contains(hash))
+        {
+            return;
+        }
+        if (_fifo._size == _capacity)
+        {
+            pop_front();
+        }
+        auto g = _free.back();
+        _free.pop_back();
+        _hashes[g] = hash;
+        _lists.push_back(_fifo, g);
+        _lookup.insert(hash, g);
+    }
+
+    void pop_front()
+    {
+        if (_fifo._size)
+        {
+            remove(_fifo._head);
+        }
+    }
+
+private:
+    uint32_t find(uint64_t hash) const
+    {
+        return _lookup.find(
+            hash,
+            [this, hash](uint32_t g){ return _hashes[g] == hash; }
+        );
+    }
+
+    void remove(uint32_t g)
+    {
+        _lookup.erase(_hashes[g], g);
+        _lists.remove(_fifo, g);
+        _free.push_back(g);
+    }
+
+    size_t _capacity;
+    slot_lists _lists;
+    slot_lists::list _fifo;
+    std::vector<uint64_t> _hashes;
+    flat_index _lookup;
+    std::vector<uint32_t> _free;
+};
+
+} // namespace detail
+
+class lru_policy
+{
+public:
+    static const bool concurrent_hits = false;
+
+    explicit lru_policy(size_t capacity) : _lists(capacity)
+    {
+    }
+
+    void on_insert(uint32_t slot, uint64_t)
+    {
+        _lists.push_back(_lru, slot);
+    }
+
+    void on_hit(uint32_t slot)
+    {
+        _lists.move_to_back(_lru, slot);
+    }
+
+    void on_miss(uint64_t) const
+    {
+    }
+
+    void on_erase(uint32_t slot)
+    {
+        _lists.remove(_lru, slot);
+    }
+
+    uint32_t victim(uint64_t) const
+    {
+        return _lru._head;
+    }
+
+    template<typename FN>
+    void for_each(FN fn) const
+    {
+        _lists.for_each(_lru, fn);
+    }
+
+private:
+    detail::slot_lists _lists;
+    // least recently used at the head.
+    detail::slot_lists::list _lru;
+};
+
+class clock_policy
+{
+public:
+    static const bool concurrent_hits = true;
+
+    explicit clock_policy(size_t capacity) :
+        _capacity(capacity),
+        _referenced(new std::atomic<uint8_t>[capacity]),
+        _present(capacity, 0),
+        _hand(0)
+    {
+        for (size_t i=0; i<capacity; ++i)
+        {
+            _referenced[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void on_insert(uint32_t slot, uint64_t)
+    {
+        _present[slot] = 1;
+        _referenced[slot].store(0, std::memory_order_relaxed);
+    }
+
+    void on_hit(uint32_t slot) const
+    {
+        // load first, so that hot items do not keep dirtying the line.
+        if (!_referenced[slot].load(std::memory_order_relaxed))
+        {
+            _referenced[slot].store(1, std::memory_order_relaxed);
+        }
+    }
+
+    void on_miss(uint64_t) const
+    {
+    }
+
+    void on_erase(uint32_t slot)
+    {
+        _present[slot] = 0;
+    }
+
+    uint32_t victim(uint64_t)
+    {
+        for (;;)
+        {
+            auto s = _hand;
+            _hand = (_hand + 1 == _capacity) ? 0 : _hand + 1;
+            if (_present[s])
+            {
+                if (!_referenced[s].load(std::memory_order_relaxed))
+                {
+                    return uint32_t(s);
+                }
+                _referenced[s].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template<typename FN>
+    void for_each(FN fn) const
+    {
+        for (size_t i=0; i<_capacity; ++i)
+        {
+            auto s = (_hand + i) % _capacity;
+            if (_present[s])
+            {
+                fn(uint32_t(s));
+            }
+        }
+    }
+
+private:
+    size_t _capacity;
+    std::unique_ptr<std::atomic<uint8_t>[]> _referenced;
+    std::vector<uint8_t> _present;
+    size_t _hand;
+};
+
+class slru_policy
+{
+public:
+    static const bool concurrent_hits = false;
+
+    explicit slru_policy(size_t capacity) :
+        _lists(capacity),
+        _protected_member(capacity, 0),
+        _protected_capacity(capacity * 4 / 5)
+    {
+    }
+
+    void on_insert(uint32_t slot, uint64_t)
+    {
+        _protected_member[slot] = 0;
+        _lists.push_back(_probation, slot);
+    }
+
+    void on_hit(uint32_t slot)
+    {
+        if (_protected_member[slot])
+        {
+            _lists.move_to_back(_protected, slot);
+            return;
+        }
+        _lists.remove(_probation, slot);
+        _lists.push_back(_protected, slot);
+        _protected_member[slot] = 1;
+        if (_protected._size > _protected_capacity)
+        {
+            auto s = _protected._head;
+            _lists.remove(_protected, s);
+            _lists.push_back(_probation, s);
+            _protected_member[s] = 0;
+        }
+    }
+
+    void on_miss(uint64_t) const
+    {
+    }
+
+    void on_erase(uint32_t slot)
+    {
+        _lists.remove(_protected_member[slot] ? _protected : _probation, slot);
+    }
+
+    uint32_t victim(uint64_t) const
+    {
+        return _probation._size ? _probation._head : _protected._head;
+    }
+
+    template<typename FN>
+    void for_each(FN fn) const
+    {
+        _lists.for_each(_probation, fn);
+        _lists.for_each(_protected, fn);
+    }
+
+private:
+    detail::slot_lists _lists;
+    detail::slot_lists::list _probation;
+    detail::slot_lists::list _protected;
+    std::vector<uint8_t> _protected_member;
+    size_t _protected_capacity;
+};
+
+class two_q_policy
+{
+public:
+    static const bool concurrent_hits = false;
+
+    explicit two_q_policy(size_t capacity) :
+        _lists(capacity),
+        _in_am(capacity, 0),
+        _hashes(capacity, 0),
+        _a1out(capacity / 2),
+        _a1in_capacity(std::max(capacity / 4, size_t(1)))
+    {
+    }
+
+    void on_insert(uint32_t slot, uint64_t hash)
+    {
+        _hashes[slot] = hash;
+        _in_am[slot] = _a1out.erase(hash) ? 1 : 0;
+        _lists.push_back(_in_am[slot] ? _am : _a1in, slot);
+    }
+
+    void on_hit(uint32_t slot)
+    {
+        // A1in is a fifo; a hit there is likely part of the same burst.
+        if (_in_am[slot])
+        {
+            _lists.move_to_back(_am, slot);
+        }
+    }
+
+    void on_miss(uint64_t) const
+    {
+    }
+
+    void on_erase(uint32_t slot)
+    {
+        _lists.remove(_in_am[slot] ? _am : _a1in, slot);
+    }
+
+    uint32_t victim(uint64_t)
+    {
+        if (_a1in._size > _a1in_capacity || _am._size == 0)
+        {
+            auto s = _a1in._head;
+            _a1out.push_back(_hashes[s]);
+            return s;
+        }
+        return _am._head;
+    }
+
+    template<typename FN>
+    void for_each(FN fn) const
+    {
+        _lists.for_each(_a1in, fn);
+        _lists.for_each(_am, fn);
+    }
+
+private:
+    detail::slot_lists _lists;
+    detail::slot_lists::list _a1in;
+    detail::slot_lists::list _am;
+    std::vector<uint8_t> _in_am;
+    std::vector<uint64_t> _hashes;
+    detail::ghost_list _a1out;
+    size_t _a1in_capacity;
+};
+
+class arc_policy
+{
+public:
+    static const bool concurrent_hits = false;
+
+    explicit arc_policy(size_t capacity) :
+        _capacity(capacity),
+        _lists(capacity),
+        _in_t2(capacity, 0),
+        _hashes(capacity, 0),
+        _b1(capacity),
+        _b2(capacity),
+        _p(0)
+    {
+    }
+
+    void on_insert(uint32_t slot, uint64_t hash)
+    {
+        _hashes[slot] = hash;
+        bool ghost = _b1.erase(hash);
+        ghost = _b2.erase(hash) || ghost;
+        _in_t2[slot] = ghost ? 1 : 0;
+        _lists.push_back(ghost ? _t2 : _t1, slot);
+    }
+
+    void on_hit(uint32_t slot)
+    {
+        if (!_in_t2[slot])
+        {
+            _lists.remove(_t1, slot);
+            _lists.push_back(_t2, slot);
+            _in_t2[slot] = 1;
+        }
+        else
+        {
+            _lists.move_to_back(_t2, slot);
+        }
+    }
+
+    void on_miss(uint64_t) const
+    {
+    }
+
+    void on_erase(uint32_t slot)
+    {
+        _lists.remove(_in_t2[slot] ? _t2 : _t1, slot);
+    }
+
+    uint32_t victim(uint64_t hash)
+    {
+        if (_b1.contains(hash))
+        {
+            _p = std::min(_capacity, _p + std::max(_b2.size() / _b1.size(), size_t(1)));
+            return replace(false);
+        }
+        if (_b2.contains(hash))
+        {
+            auto delta = std::max(_b1.size() / _b2.size(), size_t(1));
+            _p = _p > delta ? _p - delta : 0;
+            return replace(true);
+        }
+        if (_t1._size + _b1.size() >= _capacity)
+        {
+            if (_t1._size == _capacity)
+            {
+                // T1 fills the cache; drop its lru without remembering it.
+                return _t1._head;
+            }
+            _b1.pop_front();
+        }
+        else if (_t1._size + _t2._size + _b1.size() + _b2.size() >= 2 * _capacity)
+        {
+            _b2.pop_front();
+        }
+        return replace(false);
+    }
+
+    template<typename FN>
+    void for_each(FN fn) const
+    {
+        _lists.for_each(_t1, fn);
+        _lists.for_each(_t2, fn);
+    }
+
+private:
+    // eject the lru of T1 or T2 into its ghost list.
+    uint32_t replace(bool in_b2)
+    {
+        if (_t1._size
+            && (_t1._size > _p || (in_b2 && _t1._size == _p) || _t2._size == 0))
+        {
+            _b1.push_back(_hashes[_t1._head]);
+            return _t1._head;
+        }
+        _b2.push_back(_hashes[_t2._head]);
+        return _t2._head;
+    }
+
+    size_t _capacity;
+    detail::slot_lists _lists;
+    detail::slot_lists::list _t1;
+    detail::slot_lists::list _t2;
+    std::vector<uint8_t> _in_t2;
+    std::vector<uint64_t> _hashes;
+    detail::ghost_list _b1;
+    detail::ghost_list _b2;
+    // target size of T1.
+    size_t _p;
+};
+
+class lfu_policy
+{
+public:
+    static const bool concurrent_hits = false;
+
+    explicit lfu_policy(size_t capacity) :
+        _slots(capacity),
+        _bucket_of(capacity, uint32_t(npos)),
+        _buckets(capacity + 1)
+    {
+        // a bucket per distinct count, plus one while a slot moves on.
+        _free.reserve(capacity + 1);
+        for (size_t i=capacity+1; i>0; --i)
+        {
+            _free.push_back(uint32_t(i - 1));
+        }
+    }
+
+    void on_insert(uint32_t slot, uint64_t)
+    {
+        auto b = _first;
+        if (b == npos || _buckets[b]._count != 1)
+        {
+            b = new_bucket(1, npos, _first);
+        }
+        add(b, slot);
+    }
+
+    void on_hit(uint32_t slot)
+    {
+        auto b = _bucket_of[slot];
+        auto next = _buckets[b]._next;
+        if (next == npos || _buckets[next]._count != _buckets[b]._count + 1)
+        {
+            next = new_bucket(_buckets[b]._count + 1, b, next);
+        }
+        remove(slot);
+        add(next, slot);
+    }
+
+    void on_miss(uint64_t) const
+    {
+    }
+
+    void on_erase(uint32_t slot)
+    {
+        remove(slot);
+    }
+
+    uint32_t victim(uint64_t) const
+    {
+        return _buckets[_first]._slots._head;
+    }
+
+    template<typename FN>
+    void for_each(FN fn) const
+    {
+        for (auto b = _first; b != npos; b = _buckets[b]._next)
+        {
+            _slots.for_each(_buckets[b]._slots, fn);
+        }
+    }
+
+private:
+    static const uint32_t npos = detail::slot_lists::npos;
+
+    struct bucket
+    {
+        uint64_t _count = 0;
+        uint32_t _prev = npos;
+        uint32_t _next = npos;
+        // least recently used at the head.
+        detail::slot_lists::list _slots;
+    };
+
+    uint32_t new_bucket(uint64_t count, uint32_t prev, uint32_t next)
+    {
+        auto b = _free.back();
+        _free.pop_back();
+        _buckets[b] = bucket{};
+        _buckets[b]._count = count;
+        _buckets[b]._prev = prev;
+        _buckets[b]._next = next;
+        (prev == npos ? _first : _buckets[prev]._next) = b;
+        if (next != npos)
+        {
+            _buckets[next]._prev = b;
+        }
+        return b;
+    }
+
+    void add(uint32_t b, uint32_t slot)
+    {
+        _slots.push_back(_buckets[b]._slots, slot);
+        _bucket_of[slot] = b;
+    }
+
+    // remove slot from its bucket, and the bucket if it is left empty.
+    void remove(uint32_t slot)
+    {
+        auto b = _bucket_of[slot];
+        auto & k = _buckets[b];
+        _slots.remove(k._slots, slot);
+        if (k._slots._size == 0)
+        {
+            (k._prev == npos ? _first : _buckets[k._prev]._next) = k._next;
+            if (k._next != npos)
+            {
+                _buckets[k._next]._prev = k._prev;
+            }
+            _free.push_back(b);
+        }
+    }
+
+    detail::slot_lists _slots;
+    std::vector<uint32_t> _bucket_of;
+    std::vector<bucket> _buckets;
+    std::vector<uint32_t> _free;
+    // bucket of the lowest count.
+    uint32_t _first = npos;
+};
+}
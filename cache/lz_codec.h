@@ -0,0 +1,250 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A small, fast LZ77 compressor in C++11, with no dependencies, for
+//      values kept compressed in memory.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/*
+Notes:
+1.  The format is modelled on LZ4 blocks: a varint of the original size,
+    then a run of sequences, each a token byte, literals and a match. The
+    high nibble of the token is the number of literals and the low nibble
+    the match length less 4; a nibble of 15 is followed by more length
+    bytes, 255 each until one is less. The literals follow, then the offset
+    of the match back into the output, 2 bytes little endian. The last
+    sequence has only literals and ends the input.
+2.  Matches are found through a table of 4096 positions indexed by a hash of
+    the 4 bytes there, kept on the stack. Only the latest position of a
+    hash is kept, so it trades ratio for speed: a pass over the input with
+    no search. When no match turns up for a while, positions are skipped
+    faster, so incompressible input costs little.
+3.  Text such as JSON, or protobufs with repeated field names and strings,
+    typically shrinks 2 to 4 times. Random bytes grow by about 1 in 255.
+4.  decompress checks every length and offset, so a corrupt input returns
+    false and never reads or writes out of bounds.
+*/
+namespace utils
+{
+
+class lz_codec
+{
+public:
+    // Params:
+    //        data, size: the bytes to compress.
+    //        out: OUT replaced by the compressed bytes.
+    static void compress(const char * data, size_t size, std::string & out)
+    {
+        out.clear();
+        out.reserve(10 + size + size / 255 + 16);
+        put_varint(out, size);
+        auto in = reinterpret_cast<const uint8_t *>(data);
+        uint32_t table[1 << hash_bits];
+        std::memset(table, 0, sizeof(table));
+        size_t anchor = 0;
+        size_t i = 1;
+        while (i + min_match <= size)
+        {
+            auto seq = read32(in + i);
+            auto h = hash(seq);
+            size_t candidate = table[h];
+            table[h] = uint32_t(i);
+            if (i - candidate > max_offset || read32(in + candidate) != seq)
+            {
+                // step further the longer there has been no match.
+                i += 1 + ((i - anchor) >> 6);
+                continue;
+            }
+            size_t length = min_match;
+            while (i + length < size && in[candidate + length] == in[i + length])
+            {
+                ++length;
+            }
+            put_sequence(out, in + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+        }
+        if (anchor < size)
+        {
+            put_sequence(out, in + anchor, size - anchor, 0, 0);
+        }
+    }
+
+    // Params:
+    //        data, size: bytes written by compress.
+    //        out: OUT replaced by the original bytes.
+    // Return: false if data is not valid.
+    static bool decompress(const char * data, size_t size, std::string & out)
+    {
+        auto in = reinterpret_cast<const uint8_t *>(data);
+        auto end = in + size;
+        uint64_t original;
+        if (!get_varint(in, end, original)
+            || original > uint64_t(end - in) * 255 + 16)
+        {
+            return false;
+        }
+        out.resize(size_t(original));
+        size_t pos = 0;
+        while (in < end)
+        {
+            auto token = *in++;
+            size_t literals = token >> 4;
+            if (!get_length(in, end, literals)
+                || literals > size_t(end - in) || literals > out.size() - pos)
+            {
+                return false;
+            }
+            std::memcpy(&out[0] + pos, in, literals);
+            in += literals;
+            pos += literals;
+            if (in == end)
+            {
+                break;
+            }
+            if (end - in < 2)
+            {
+                return false;
+            }
+            size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+            in += 2;
+            size_t length = token & 15;
+            if (!get_length(in, end, length))
+            {
+                return false;
+            }
+            length += min_match;
+            if (offset == 0 || offset > pos || length > out.size() - pos)
+            {
+                return false;
+            }
+            auto dst = &out[0] + pos;
+            auto src = dst - offset;
+            if (offset >= length)
+            {
+                std::memcpy(dst, src, length);
+            }
+            else
+            {
+                // overlapping; a run repeating the last offset bytes.
+                for (size_t k=0; k<length; ++k)
+                {
+                    dst[k] = src[k];
+                }
+            }
+            pos += length;
+        }
+        return pos == out.size();
+    }
+
+private:
+    static const size_t min_match = 4;
+    static const size_t max_offset = 65535;
+    static const int hash_bits = 12;
+
+    static uint32_t read32(const uint8_t * p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static uint32_t hash(uint32_t seq)
+    {
+        return (seq * 2654435761u) >> (32 - hash_bits);
+    }
+
+    static void put_varint(std::string & out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(char(uint8_t(v) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(char(v));
+    }
+
+    static bool get_varint(const uint8_t * & in, const uint8_t * end, uint64_t & v)
+    {
+        v = 0;
+        for (int shift=0; shift<64 && in < end; shift+=7)
+        {
+            auto b = *in++;
+            v |= uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the bytes extending a length of 15 or more.
+    static void put_length(std::string & out, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            out.push_back(char(255));
+        }
+        out.push_back(char(length));
+    }
+
+    static bool get_length(const uint8_t * & in, const uint8_t * end, size_t & length)
+    {
+        if (length < 15)
+        {
+            return true;
+        }
+        for (;;)
+        {
+            if (in == end)
+            {
+                return false;
+            }
+            auto b = *in++;
+            length += b;
+            if (b < 255)
+            {
+                return true;
+            }
+        }
+    }
+
+    // a sequence of literals and a match; length 0 for none.
+    static void put_sequence(
+        std::string & out, const uint8_t * literals, size_t count,
+        size_t offset, size_t length
+    )
+    {
+        auto match = length ? length - min_match : 0;
+        out.push_back(char(
+            (count < 15 ? count : 15) << 4 | (match < 15 ? match : 15)
+        ));
+        if (count >= 15)
+        {
+            put_length(out, count - 15);
+        }
+        out.append(reinterpret_cast<const char *>(literals), count);
+        if (length == 0)
+        {
+            return;
+        }
+        out.push_back(char(offset & 0xFF));
+        out.push_back(char(offset >> 8));
+        if (match >= 15)
+        {
+            put_length(out, match - 15);
+        }
+    }
+};
+}
@@ -0,0 +1,159 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A read only memory mapped file in C++11.
+//      Uses mmap on POSIX systems and a file mapping on Windows.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+Notes:
+The whole file is mapped at construction and unmapped at destruction.
+Pages are read from the file as they are first touched, so reading a file
+front to back through the mapping needs no buffer of its own.
+The access pattern given at construction is passed on to the kernel:
+sequential reads ahead and drops pages behind the reader, random reads
+only the pages touched, for point lookups at scattered offsets.
+If the file cannot be opened or mapped, is_open() is false. An empty file
+is open with size 0 and data nullptr.
+*/
+namespace utils
+{
+
+class mapped_file
+{
+public:
+    enum class access
+    {
+        sequential,
+        random
+    };
+
+    explicit mapped_file(const std::string & path, access pattern = access::sequential) :
+        _data(nullptr), _size(0), _open(false)
+    {
+#ifdef _WIN32
+        auto file = CreateFileA(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            pattern == access::sequential
+                ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS,
+            nullptr
+        );
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size))
+        {
+            _size = size_t(size.QuadPart);
+            _open = true;
+            if (_size)
+            {
+                auto mapping = CreateFileMappingA(
+                    file, nullptr, PAGE_READONLY, 0, 0, nullptr
+                );
+                if (mapping)
+                {
+                    _data = static_cast<const char *>(
+                        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+                    );
+                    CloseHandle(mapping);
+                }
+                _open = (_data != nullptr);
+            }
+        }
+        CloseHandle(file);
+#else
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0)
+        {
+            _size = size_t(st.st_size);
+            _open = true;
+            if (_size)
+            {
+                auto p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED)
+                {
+                    _open = false;
+                }
+                else
+                {
+                    _data = static_cast<const char *>(p);
+                    ::madvise(
+                        p, _size,
+                        pattern == access::sequential ? MADV_SEQUENTIAL : MADV_RANDOM
+                    );
+                }
+            }
+        }
+        // the mapping keeps the file open.
+        ::close(fd);
+#endif
+        if (!_open)
+        {
+            _size = 0;
+        }
+    }
+
+    ~mapped_file()
+    {
+        if (_data)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(_data);
+#else
+            ::munmap(const_cast<char *>(_data), _size);
+#endif
+        }
+    }
+
+    inline bool is_open() const
+    {
+        return _open;
+    }
+
+    inline const char * data() const
+    {
+        return _data;
+    }
+
+    inline size_t size() const
+    {
+        return _size;
+    }
+
+    // No copy construction or assignment.
+    mapped_file(const mapped_file &) = delete;
+    mapped_file & operator=(const mapped_file &) = delete;
+
+private:
+    const char * _data;
+    size_t _size;
+    bool _open;
+};
+}
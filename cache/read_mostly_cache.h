@@ -0,0 +1,374 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A read mostly cache in C++11.
+//      Readers look up an immutable version of the cache without locks or
+//      writes to shared lines, so reads scale with cores. Writers build and
+//      publish a new version, and free the old one once no reader can be
+//      using it.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cache_index.h"
+
+/*
+Notes:
+1.  A version is an array of items and a flat_index over it, never
+    changed once published, except for the recency stamp of items.
+    get loads the current version and looks the key up in it.
+2.  Reclamation: readers count themselves in one of 128 slots, each on its
+    own cache line, a thread always using the same slot. A slot has two
+    counters, and a reader increments the one of the current epoch parity
+    for the time of its lookup. To free the version it replaced, a writer
+    waits for the counters of the other parity to drain, flips the epoch,
+    then waits for the counters of the old parity to drain. A reader that
+    counted itself after that first wait started can only have loaded the
+    new version. New readers count in the new parity, so a writer waits for
+    a bounded set of readers and is never starved. So reads are wait-free:
+    two atomic increments on a line of their own and no retry.
+    The slots are aligned to 64 bytes, so before C++17 a cache allocated
+    with new may not keep its slots on lines of their own.
+3.  Recency is approximate: a get stamps the item with the number of the
+    version it read, storing only if the stamp changed, so items read
+    often write their line once per version. When a write takes the cache
+    over capacity, the items with the oldest stamps are dropped.
+4.  Every write copies the items into a new version, O(size) per write. So
+    it suits rare, bulk updates; use put_all for many items at once.
+5.  Writers are serialized by a mutex and wait for readers in flight, so a
+    write takes at least the longest lookup running at the time.
+*/
+namespace utils
+{
+
+template<
+    typename KEY, typename VAL,
+    typename HASH = std::hash<KEY>, typename KEYEQ = std::equal_to<KEY>
+>
+class read_mostly_cache
+{
+public:
+    explicit read_mostly_cache(size_t capacity = 1024) :
+        _capacity(capacity), _epoch(0), _version(new version(0))
+    {
+        for (auto & r : _readers)
+        {
+            r._count[0] = 0;
+            r._count[1] = 0;
+        }
+    }
+
+    ~read_mostly_cache()
+    {
+        delete _version.load();
+    }
+
+    // if found in cache, copies to val and return true. Wait-free.
+    bool get(const KEY & key, VAL & val) const
+    {
+        read_section r(*this);
+        auto v = _version.load();
+        auto i = v->find(key, hash_of(key));
+        if (i == npos)
+        {
+            return false;
+        }
+        const auto & it = v->_items[i];
+        // store only if changed, so hot items do not bounce their line.
+        if (it._used.load(std::memory_order_relaxed) != v->_number)
+        {
+            it._used.store(v->_number, std::memory_order_relaxed);
+        }
+        val = it._val;
+        return true;
+    }
+
+    // Return: true if key is in the cache. Not a use of the item.
+    bool contains(const KEY & key) const
+    {
+        read_section r(*this);
+        auto v = _version.load();
+        return v->find(key, hash_of(key)) != npos;
+    }
+
+    void put(const KEY & key, const VAL & val)
+    {
+        std::vector<std::pair<KEY, VAL>> items;
+        items.emplace_back(key, val);
+        put_all(items);
+    }
+
+    // put many items as one new version.
+    void put_all(const std::vector<std::pair<KEY, VAL>> & items)
+    {
+        std::lock_guard<std::mutex> l{_write_mutex};
+        auto old = _version.load();
+        std::unique_ptr<version> v{new version(old->_number + 1)};
+        v->_items.reserve(old->_items.size() + items.size());
+        // an index of room for all, to merge items before trimming.
+        flat_index index(old->_items.size() + items.size());
+        for (const auto & it : old->_items)
+        {
+            v->_items.push_back(it);
+            index.insert(it._hash, uint32_t(v->_items.size() - 1));
+        }
+        for (const auto & kv : items)
+        {
+            auto hash = hash_of(kv.first);
+            auto i = v->find(kv.first, hash, index);
+            if (i == npos)
+            {
+                v->_items.push_back(item(kv.first, kv.second, hash, v->_number));
+                index.insert(hash, uint32_t(v->_items.size() - 1));
+            }
+            else
+            {
+                v->_items[i]._val = kv.second;
+                v->_items[i]._used.store(v->_number, std::memory_order_relaxed);
+            }
+        }
+        trim(*v);
+        publish(v.release());
+    }
+
+    // Return: true if key was in the cache.
+    bool erase(const KEY & key)
+    {
+        std::lock_guard<std::mutex> l{_write_mutex};
+        auto old = _version.load();
+        auto i = old->find(key, hash_of(key));
+        if (i == npos)
+        {
+            return false;
+        }
+        std::unique_ptr<version> v{new version(old->_number + 1)};
+        v->_items.reserve(old->_items.size() - 1);
+        for (size_t j=0; j<old->_items.size(); ++j)
+        {
+            if (j != i)
+            {
+                v->_items.push_back(old->_items[j]);
+            }
+        }
+        v->build();
+        publish(v.release());
+        return true;
+    }
+
+    size_t size() const
+    {
+        read_section r(*this);
+        return _version.load()->_items.size();
+    }
+
+    inline size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    // check the consistency of internal data structures.
+    // Params:
+    //        details: OUT returns the detailed consistency check results.
+    // Return: true if ok.
+    bool check_consistency(std::string & details)
+    {
+        std::lock_guard<std::mutex> l{_write_mutex};
+        auto v = _version.load();
+        bool ok = v->_items.size() <= _capacity;
+        for (size_t i=0; ok && i<v->_items.size(); ++i)
+        {
+            const auto & it = v->_items[i];
+            ok = v->find(it._key, it._hash) == i;
+        }
+        details = ok ? "ok" : "item not found in index";
+        return ok;
+    }
+
+    // No copy construction or assignment.
+    read_mostly_cache(const read_mostly_cache &) = delete;
+    read_mostly_cache & operator=(const read_mostly_cache &) = delete;
+
+private:
+    static const uint32_t npos = flat_index::npos;
+    static const size_t num_reader_slots = 128;
+    static const size_t cache_line_size = 64;
+
+    struct item
+    {
+        item(const KEY & key, const VAL & val, uint64_t hash, uint64_t used) :
+            _key(key), _val(val), _hash(hash), _used(used)
+        {
+        }
+
+        item(const item & other) :
+            _key(other._key), _val(other._val), _hash(other._hash),
+            _used(other._used.load(std::memory_order_relaxed))
+        {
+        }
+
+        item & operator=(const item & other)
+        {
+            _key = other._key;
+            _val = other._val;
+            _hash = other._hash;
+            _used.store(
+                other._used.load(std::memory_order_relaxed), std::memory_order_relaxed
+            );
+            return *this;
+        }
+
+        KEY _key;
+        VAL _val;
+        uint64_t _hash;
+        // number of the version last read from.
+        mutable std::atomic<uint64_t> _used;
+    };
+
+    struct version
+    {
+        explicit version(uint64_t number) : _number(number), _index(0)
+        {
+        }
+
+        uint32_t find(const KEY & key, uint64_t hash) const
+        {
+            return find(key, hash, _index);
+        }
+
+        uint32_t find(const KEY & key, uint64_t hash, const flat_index & index) const
+        {
+            return index.find(
+                hash,
+                [this, &key](uint32_t s){ return KEYEQ{}(_items[s]._key, key); }
+            );
+        }
+
+        // index all items afresh.
+        void build()
+        {
+            _index = flat_index(_items.size());
+            for (size_t s=0; s<_items.size(); ++s)
+            {
+                _index.insert(_items[s]._hash, uint32_t(s));
+            }
+        }
+
+        uint64_t _number;
+        std::vector<item> _items;
+        // index of _items, built once before the version is published.
+        flat_index _index;
+    };
+
+    // reader counters of the two epoch parities, alone on a cache line.
+    struct alignas(cache_line_size) reader_slot
+    {
+        std::atomic<uint32_t> _count[2];
+    };
+    static_assert(
+        sizeof(reader_slot) == cache_line_size && alignof(reader_slot) == cache_line_size,
+        "reader_slot must fill exactly one cache line"
+    );
+
+    // counts a reader in its slot while in scope.
+    class read_section
+    {
+    public:
+        explicit read_section(const read_mostly_cache & c) :
+            _count(c._readers[slot_index()]._count[c._epoch.load() & 1])
+        {
+            _count.fetch_add(1);
+        }
+
+        ~read_section()
+        {
+            _count.fetch_sub(1);
+        }
+
+    private:
+        std::atomic<uint32_t> & _count;
+    };
+
+    static size_t slot_index()
+    {
+        // round robin over threads, so threads share slots only when
+        // there are more than num_reader_slots of them.
+        static std::atomic<size_t> next{0};
+        thread_local size_t index = next.fetch_add(1) % num_reader_slots;
+        return index;
+    }
+
+    static uint64_t hash_of(const KEY & key)
+    {
+        return detail::mix_hash(uint64_t(HASH{}(key)));
+    }
+
+    // drop the least recently read items over capacity, and index the rest.
+    void trim(version & v)
+    {
+        if (v._items.size() > _capacity)
+        {
+            auto used = [](const item & a, const item & b){
+                return a._used.load(std::memory_order_relaxed)
+                    > b._used.load(std::memory_order_relaxed);
+            };
+            std::nth_element(
+                v._items.begin(), v._items.begin() + _capacity, v._items.end(), used
+            );
+            while (v._items.size() > _capacity)
+            {
+                v._items.pop_back();
+            }
+        }
+        v.build();
+    }
+
+    // make v the current version and free the one it replaces.
+    void publish(version * v)
+    {
+        auto old = _version.exchange(v);
+        synchronize();
+        delete old;
+    }
+
+    // wait until no reader can be using a version replaced before the call.
+    void synchronize()
+    {
+        auto parity = _epoch.load() & 1;
+        wait_readers(parity ^ 1);
+        _epoch.fetch_add(1);
+        wait_readers(parity);
+    }
+
+    void wait_readers(size_t parity)
+    {
+        for (auto & r : _readers)
+        {
+            while (r._count[parity].load() != 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    size_t _capacity;
+    mutable reader_slot _readers[num_reader_slots];
+    std::atomic<uint64_t> _epoch;
+    std::atomic<version *> _version;
+    std::mutex _write_mutex;
+};
+}
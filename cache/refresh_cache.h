@@ -0,0 +1,221 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A refresh ahead cache in C++11 on top of concurrent_cache.
+//      Items have a soft and a hard time to live. Past the soft one, get
+//      still returns the cached value at once and reloads it on a
+//      thread_pool, so a hot key never stalls its readers on a reload.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "concurrent_cache.h"
+#include "../thread_pool/thread_pool.h"
+
+/*
+Notes:
+1.  Every item is loaded by the loader given at construction. get of a key
+    that is not cached, or whose hard ttl has passed, calls the loader and
+    waits for it, single flight as concurrent_cache::get_or_load.
+2.  get of an item past its soft ttl returns the stale value and posts one
+    reload of the key to the thread_pool; the item keeps a flag so that the
+    other gets until the reload is put do not post again. The reloaded
+    value is put with fresh soft and hard ttls.
+3.  A reload that throws is dropped and the stale value keeps being served;
+    the next get posts a reload again. Once the hard ttl passes, get loads
+    in the foreground and the exception reaches the caller.
+4.  Pick the soft ttl for how fresh items should be and the hard ttl for how
+    stale an item may ever get. A key read at least once between the two
+    never has a foreground reload.
+5.  The thread_pool must outlive the cache. The destructor waits for the
+    reloads in flight.
+*/
+namespace utils
+{
+
+template<
+    typename KEY, typename VAL,
+    typename POLICY = lru_policy, typename HASH = std::hash<KEY>,
+    typename KEYEQ = std::equal_to<KEY>
+>
+class refresh_cache
+{
+    // the cached value and when it turns stale.
+    struct entry;
+    using cache_type = concurrent_cache<KEY, entry, POLICY, HASH, KEYEQ>;
+
+public:
+    using clock = typename cache_type::clock;
+    using loader_type = std::function<VAL(const KEY &)>;
+
+    // Params:
+    //        pool: runs the background reloads.
+    //        loader: loads the value of a key; may throw.
+    //        soft_ttl: age after which a get reloads in the background.
+    //        hard_ttl: age after which a get reloads in the foreground;
+    //                  at least soft_ttl.
+    //        capacity, num_shards: see concurrent_cache.
+    refresh_cache(
+        thread_pool & pool, loader_type loader,
+        typename clock::duration soft_ttl, typename clock::duration hard_ttl,
+        size_t capacity = 1024, size_t num_shards = 16
+    ) :
+        _pool(pool),
+        _loader(std::move(loader)),
+        _soft_ttl(soft_ttl),
+        _hard_ttl(hard_ttl),
+        _cache(capacity, num_shards),
+        _pending(0),
+        _refreshes(0),
+        _refresh_failures(0)
+    {
+    }
+
+    ~refresh_cache()
+    {
+        std::unique_lock<std::mutex> l{_mutex};
+        _idle.wait(l, [this]{ return _pending == 0; });
+    }
+
+    // Return: the value of key, cached or loaded. Rethrows an exception
+    //         from a foreground load.
+    std::shared_ptr<const VAL> get(const KEY & key)
+    {
+        auto e = _cache.get(key);
+        if (!e)
+        {
+            e = _cache.get_or_load(
+                key, [this](const KEY & k){ return load(k); }, _hard_ttl
+            );
+        }
+        else if (clock::now() >= e->_stale && !e->_refreshing.exchange(true))
+        {
+            refresh(key, e);
+        }
+        // shares ownership with the entry.
+        return std::shared_ptr<const VAL>(e, &e->_val);
+    }
+
+    // put a value loaded elsewhere, with fresh ttls.
+    void put(const KEY & key, const VAL & val)
+    {
+        _cache.put(key, entry(val, clock::now() + _soft_ttl), _hard_ttl);
+    }
+
+    // Return: true if key was in the cache.
+    bool erase(const KEY & key)
+    {
+        return _cache.erase(key);
+    }
+
+    size_t size()
+    {
+        return _cache.size();
+    }
+
+    // Return: number of background reloads put.
+    size_t refreshes() const
+    {
+        return _refreshes.load(std::memory_order_relaxed);
+    }
+
+    // Return: number of background reloads that threw.
+    size_t refresh_failures() const
+    {
+        return _refresh_failures.load(std::memory_order_relaxed);
+    }
+
+    typename cache_type::stats get_stats()
+    {
+        return _cache.get_stats();
+    }
+
+    bool check_consistency(std::string & details)
+    {
+        return _cache.check_consistency(details);
+    }
+
+    // No copy construction or assignment.
+    refresh_cache(const refresh_cache &) = delete;
+    refresh_cache & operator=(const refresh_cache &) = delete;
+
+private:
+    struct entry
+    {
+        entry(const VAL & val, typename clock::time_point stale) :
+            _val(val), _stale(stale), _refreshing{false}
+        {
+        }
+
+        // a copy is a new entry, not being reloaded.
+        entry(const entry & other) :
+            _val(other._val), _stale(other._stale), _refreshing{false}
+        {
+        }
+
+        VAL _val;
+        typename clock::time_point _stale;
+        // set by the get that posts the reload.
+        mutable std::atomic<bool> _refreshing;
+    };
+
+    using handle = std::shared_ptr<const entry>;
+
+    entry load(const KEY & key)
+    {
+        auto val = _loader(key);
+        return entry(val, clock::now() + _soft_ttl);
+    }
+
+    void refresh(const KEY & key, handle stale)
+    {
+        {
+            std::lock_guard<std::mutex> l{_mutex};
+            ++_pending;
+        }
+        _pool.post([this, key, stale](){
+            try
+            {
+                _cache.put(key, load(key), _hard_ttl);
+                _refreshes.fetch_add(1, std::memory_order_relaxed);
+            }
+            catch (...)
+            {
+                // let a later get try again.
+                _refresh_failures.fetch_add(1, std::memory_order_relaxed);
+                stale->_refreshing = false;
+            }
+            std::lock_guard<std::mutex> l{_mutex};
+            if (--_pending == 0)
+            {
+                _idle.notify_all();
+            }
+        });
+    }
+
+    thread_pool & _pool;
+    loader_type _loader;
+    typename clock::duration _soft_ttl;
+    typename clock::duration _hard_ttl;
+    cache_type _cache;
+
+    // background reloads posted and not yet done.
+    std::mutex _mutex;
+    std::condition_variable _idle;
+    size_t _pending;
+
+    std::atomic<size_t> _refreshes;
+    std::atomic<size_t> _refresh_failures;
+};
+}
@@ -7,6 +7,45 @@ using std::cout;
 using std::string;
 #include <chrono>
 using std::chrono::system_clock;
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+#if __cplusplus >= 201703L
+#include <memory>
+#include <string_view>
+
+// count allocations of the keys, to check that lookups by string_view do
+// not build a key.
+size_t allocations = 0;
+
+template<typename T>
+struct counting_allocator : std::allocator<T>
+{
+    template<typename U>
+    struct rebind
+    {
+        using other = counting_allocator<U>;
+    };
+
+    counting_allocator() = default;
+
+    template<typename U>
+    counting_allocator(const counting_allocator<U> &)
+    {
+    }
+
+    T * allocate(size_t n)
+    {
+        ++allocations;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+using counted_string =
+    std::basic_string<char, std::char_traits<char>, counting_allocator<char>>;
+#endif
 
 struct page_cache_value
 {
@@ -86,6 +125,736 @@ void test_capacity_eject_lru()
     );
 }
 
+template<typename INDEX>
+void test_capacity_churn(const char * what)
+{
+    // reference model of an lru cache: most recently used at the back.
+    std::vector<int> model;
+    utils::cache<int, int, lru_policy, INDEX> c(64);
+    bool ok = true;
+    unsigned seed = 7;
+    for (int i=0; ok && i<20000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        int key = (seed >> 16) % 200;
+        auto itr = std::find(model.begin(), model.end(), key);
+        int val = 0;
+        bool found = c.get(key, val);
+        ok = (found == (itr != model.end())) && (!found || val == key * 3);
+        if (found)
+        {
+            model.erase(itr);
+            model.push_back(key);
+        }
+        else
+        {
+            c.put(key, key * 3);
+            if (model.size() == 64)
+            {
+                model.erase(model.begin());
+            }
+            model.push_back(key);
+        }
+    }
+    string ignore;
+    ASSERT_M(ok && c.size() == 64 && c.check_consistency(ignore), what);
+}
+
+void test_zero_capacity()
+{
+    utils::cache<int, int> c(0);
+    c.put(1, 1);
+    int val = 0;
+    ASSERT_M(c.size() == 0 && !c.get(1, val), "zero capacity cache holds nothing");
+}
+
+void test_clock_policy()
+{
+    page_cache_value cached_page;
+    utils::cache<string, page_cache_value, clock_policy> page_cache(2);
+    page_cache.put("http://abc.com", page_cache_value{ "yak yak", system_clock::now().time_since_epoch().count() });
+    page_cache.put("http://rextester.com", page_cache_value{ "blah blah", system_clock::now().time_since_epoch().count() });
+    page_cache.get_shared("http://abc.com", cached_page);
+    page_cache.put("http://fakenews.com", page_cache_value{ "yada yada", system_clock::now().time_since_epoch().count() });
+
+    string ignore;
+    ASSERT_M(
+        page_cache.get("http://abc.com", cached_page) && ! page_cache.get("http://rextester.com", cached_page)
+            && page_cache.size() == 2 && page_cache.check_consistency(ignore),
+        "clock policy ejects unreferenced item"
+    );
+}
+
+template<typename POLICY>
+void test_policy_churn(const char * what)
+{
+    utils::cache<int, int, POLICY> c(64);
+    unsigned seed = 7;
+    bool ok = true;
+    for (int i=0; ok && i<20000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        // skewed keys, with a scan of one-off keys now and then.
+        int key = int(((seed >> 16) % 300) * ((seed >> 8) % 300) / 300);
+        if (i % 1000 < 100)
+        {
+            key = 1000 + i;
+        }
+        int val = 0;
+        if (c.get(key, val))
+        {
+            ok = (val == key * 3);
+        }
+        else
+        {
+            c.put(key, key * 3);
+        }
+    }
+    string ignore;
+    ASSERT_M(ok && c.size() == 64 && c.check_consistency(ignore), what);
+}
+
+// put keys in [first, last), reading each one once.
+template<typename CACHE>
+void scan(CACHE & c, int first, int last)
+{
+    int val = 0;
+    for (int key=first; key<last; ++key)
+    {
+        c.put(key, key);
+        c.get(key, val);
+    }
+}
+
+template<typename CACHE>
+bool has_keys(CACHE & c, int first, int last)
+{
+    int val = 0;
+    bool ok = true;
+    for (int key=first; key<last; ++key)
+    {
+        ok = c.get(key, val) && ok;
+    }
+    return ok;
+}
+
+void test_slru_policy()
+{
+    utils::cache<int, int, slru_policy> c(10);
+    scan(c, 0, 4);
+    for (int key=100; key<150; ++key)
+    {
+        c.put(key, key);
+    }
+    string ignore;
+    ASSERT_M(
+        has_keys(c, 0, 4) && c.check_consistency(ignore),
+        "slru keeps items read again through a scan"
+    );
+}
+
+void test_two_q_policy()
+{
+    utils::cache<int, int, two_q_policy> c(8);
+    for (int key=0; key<9; ++key)
+    {
+        c.put(key, key);
+    }
+    // 0 was ejected from A1in into A1out, so coming back it goes to Am.
+    c.put(0, 0);
+    for (int key=100; key<150; ++key)
+    {
+        c.put(key, key);
+    }
+    string ignore;
+    ASSERT_M(
+        has_keys(c, 0, 1) && c.check_consistency(ignore),
+        "2q keeps a key seen again after ejection through a scan"
+    );
+}
+
+void test_arc_policy()
+{
+    utils::cache<int, int, arc_policy> c(8);
+    scan(c, 0, 4);
+    has_keys(c, 0, 4);
+    for (int key=100; key<150; ++key)
+    {
+        c.put(key, key);
+    }
+    string ignore;
+    ASSERT_M(
+        has_keys(c, 0, 4) && c.check_consistency(ignore),
+        "arc keeps items seen twice through a scan"
+    );
+}
+
+void test_lfu_policy()
+{
+    utils::cache<int, int, lfu_policy> c(3);
+    int val = 0;
+    c.put(1, 1);
+    c.put(2, 2);
+    c.put(3, 3);
+    c.get(1, val);
+    c.get(1, val);
+    c.get(2, val);
+    c.put(4, 4);    // ejects 3, the least frequently used.
+    c.put(5, 5);    // ejects 4, the least frequently used.
+    string ignore;
+    ASSERT_M(
+        !c.get(3, val) && !c.get(4, val) && has_keys(c, 1, 3) && has_keys(c, 5, 6)
+            && c.check_consistency(ignore),
+        "lfu ejects the least frequently used item"
+    );
+}
+
+template<typename POLICY>
+void test_erase_churn(const char * what)
+{
+    utils::cache<int, int, POLICY> c(64);
+    unsigned seed = 7;
+    bool ok = true;
+    for (int i=0; ok && i<20000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        int key = int((seed >> 16) % 150);
+        int val = 0;
+        if (i % 5 == 0)
+        {
+            c.erase(key);
+            ok = !c.get(key, val);
+        }
+        else if (!c.get(key, val))
+        {
+            c.put(key, key);
+        }
+    }
+    string ignore;
+    ASSERT_M(ok && c.size() <= 64 && c.check_consistency(ignore), what);
+}
+
+void test_erase()
+{
+    utils::cache<int, int> c(2);
+    c.put(1, 1);
+    c.put(2, 2);
+    bool erased = c.erase(1) && !c.erase(1);
+    c.put(3, 3);
+    int val = 0;
+    string ignore;
+    ASSERT_M(
+        erased && c.size() == 2 && !c.get(1, val) && has_keys(c, 2, 4)
+            && c.check_consistency(ignore),
+        "erase frees a slot for the next put"
+    );
+}
+
+void test_ttl_lazy_expiry()
+{
+    utils::cache<int, int> c(4);
+    c.put(1, 1, std::chrono::milliseconds(20));
+    c.put(2, 2);
+    int val = 0;
+    bool before = c.get(1, val);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    string ignore;
+    ASSERT_M(
+        before && !c.get(1, val) && c.get(2, val) && c.size() == 1
+            && c.check_consistency(ignore),
+        "get of an expired item is a miss and erases it"
+    );
+}
+
+void test_ttl_put_clears_expiry()
+{
+    utils::cache<int, int> c(4);
+    c.put(1, 1, std::chrono::milliseconds(20));
+    c.put(1, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    c.expire();
+    int val = 0;
+    ASSERT_M(c.get(1, val) && val == 2, "put without ttl makes an item never expire");
+}
+
+void test_ttl_reclaim_before_eject()
+{
+    utils::cache<int, int> c(4);
+    c.put(1, 1);
+    c.put(2, 2, std::chrono::milliseconds(20));
+    c.put(3, 3, std::chrono::milliseconds(20));
+    c.put(4, 4);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // expired 2 and 3 make room; 1 and 4 are not ejected.
+    c.put(5, 5);
+    c.put(6, 6);
+    int val = 0;
+    string ignore;
+    ASSERT_M(
+        has_keys(c, 4, 7) && c.get(1, val) && !c.get(2, val) && !c.get(3, val)
+            && c.size() == 4 && c.check_consistency(ignore),
+        "expired items are erased before live items are ejected"
+    );
+}
+
+void test_ttl_expire()
+{
+    utils::cache<int, int, arc_policy> c(100);
+    for (int key=0; key<100; ++key)
+    {
+        c.put(key, key, std::chrono::milliseconds(key % 2 ? 20 : 100000));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    c.expire();
+    string ignore;
+    ASSERT_M(c.size() == 50 && c.check_consistency(ignore), "expire erases all expired items");
+}
+
+size_t page_weight(const string & key, const string & page)
+{
+    return key.size() + page.size();
+}
+
+void test_weight_budget()
+{
+    utils::cache<string, string> c(100, 50, page_weight);
+    bool ok = true;
+    for (int i=0; i<100; ++i)
+    {
+        auto key = std::to_string(i);
+        ok = c.put(key, string(size_t(i % 20), 'x')) && c.weight() <= 50 && ok;
+    }
+    string ignore;
+    ASSERT_M(ok && c.check_consistency(ignore), "cache weight stays within max weight");
+}
+
+void test_weight_ejects_until_fit()
+{
+    utils::cache<string, string> c(100, 50, page_weight);
+    for (int i=0; i<5; ++i)
+    {
+        c.put(std::to_string(i), string(9, 'x'));
+    }
+    // weight 50 now; a 30 heavy item ejects the 3 least recently used.
+    c.put("a", string(29, 'x'));
+    string val;
+    string ignore;
+    ASSERT_M(
+        c.size() == 3 && c.weight() == 50 && !c.get("2", val) && c.get("3", val)
+            && c.get("a", val) && c.check_consistency(ignore),
+        "cache ejects until a heavy item fits"
+    );
+}
+
+void test_weight_rejects_too_heavy()
+{
+    utils::cache<string, string> c(100, 50, page_weight);
+    c.put("a", "small");
+    bool too_heavy = c.put("b", string(50, 'x'));
+    // an update too heavy to fit erases the old value.
+    bool update_too_heavy = c.put("a", string(50, 'x'));
+    string val;
+    ASSERT_M(
+        !too_heavy && !update_too_heavy && c.size() == 0 && c.weight() == 0
+            && !c.get("a", val),
+        "cache rejects an item heavier than max weight"
+    );
+}
+
+void test_weight_update()
+{
+    utils::cache<string, string> c(100, 50, page_weight);
+    c.put("a", string(19, 'x'));
+    c.put("b", string(19, 'x'));
+    c.put("a", string(9, 'x'));     // lighter, in place.
+    c.put("b", string(44, 'x'));    // heavier, ejects a.
+    string val;
+    string ignore;
+    ASSERT_M(
+        c.weight() == 45 && !c.get("a", val) && c.get("b", val) && val.size() == 44
+            && c.check_consistency(ignore),
+        "cache weight follows updates"
+    );
+}
+
+void test_weight_reused_slots()
+{
+    auto size_weight = [](const int &, const string & val){ return val.size(); };
+    utils::cache<int, string> c(4, 1000000, size_weight);
+    for (int key=0; key<4; ++key)
+    {
+        c.put(key, string(200000, 'x'));
+    }
+    // ejected slots are reused, and key 0 is updated in place.
+    for (int key=4; key<1000; ++key)
+    {
+        c.put(key, string(10, 'y'));
+    }
+    c.put(999, string(5, 'z'));
+    size_t held = 0;
+    for (int key=996; key<1000; ++key)
+    {
+        auto p = c.get(key);
+        held += p ? p->capacity() : 1000000;
+    }
+    ASSERT_M(
+        c.weight() == 35 && held < 1000,
+        "cache reused slots do not keep the memory of old values"
+    );
+}
+
+void test_get_no_copy()
+{
+    utils::cache<string, string> c(2);
+    c.put("a", string(1000, 'x'));
+    auto p1 = c.get("a");
+    auto p2 = c.get("a");
+    ASSERT_M(
+        p1 && p1 == p2 && p1->size() == 1000 && c.get("b") == nullptr,
+        "cache get without copying the value"
+    );
+}
+
+void test_custom_hash()
+{
+    struct key_hash
+    {
+        size_t operator()(const string & key) const
+        {
+            return key.size();
+        }
+    };
+    // every key of a size collides; lookups must still compare keys.
+    utils::cache<string, int, lru_policy, flat_index, key_hash> c(8);
+    c.put("ab", 1);
+    c.put("cd", 2);
+    int val = 0;
+    ASSERT_M(
+        c.get("cd", val) && val == 2 && c.contains("ab") && !c.contains("ef"),
+        "cache with a custom hash"
+    );
+}
+
+void test_multi_get()
+{
+    utils::cache<string, int> c(41);
+    for (int i=0; i<40; ++i)
+    {
+        c.put(std::to_string(i), i);
+    }
+    c.put("x", -1, std::chrono::milliseconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    // more keys than a batch, hits, misses and an expired key.
+    std::vector<string> keys;
+    for (int i=39; i>=0; i-=2)
+    {
+        keys.push_back(std::to_string(i));
+        keys.push_back("missing" + std::to_string(i));
+    }
+    keys.push_back("x");
+    std::vector<const int *> vals;
+    auto found = c.multi_get(keys, vals);
+    bool match = vals.size() == keys.size();
+    for (size_t i=0; match && i+1<keys.size(); i+=2)
+    {
+        match = vals[i] && *vals[i] == std::stoi(keys[i]) && !vals[i + 1];
+    }
+    // the odd keys were used, so the even ones are the lru.
+    c.put("y", 0);
+    c.put("z", 0);
+    ASSERT_M(
+        found == 20 && match && !vals.back() && !c.contains("0")
+            && c.contains("1") && c.contains("3") && c.size() == 41,
+        "cache multi_get finds the same as get and uses the items"
+    );
+}
+
+void test_multi_put()
+{
+    utils::cache<int, int> c(20, 50, [](const int &, const int & v){ return size_t(v); });
+    std::vector<std::pair<int, int>> items;
+    for (int i=0; i<30; ++i)
+    {
+        items.emplace_back(i, 1);
+    }
+    items.emplace_back(100, 51);    // too heavy.
+    items.emplace_back(29, 2);      // an update.
+    auto put = c.multi_put(items);
+    int val = 0;
+    string ignore;
+    ASSERT_M(
+        put == 31 && c.size() == 20 && c.weight() == 21 && !c.contains(9)
+            && c.get(10, val) && c.get(29, val) && val == 2
+            && c.check_consistency(ignore),
+        "cache multi_put is the same as put one after the other"
+    );
+}
+
+void test_removal_listener()
+{
+    utils::cache<int, int> c(2);
+    std::vector<std::pair<int, removal_cause>> removed;
+    c.set_removal_listener([&removed](const int & key, const int & val, removal_cause cause){
+        if (key == val)
+        {
+            removed.emplace_back(key, cause);
+        }
+    });
+    c.put(1, 1);
+    c.put(2, 2, std::chrono::milliseconds(10));
+    c.put(1, 1);                    // an update is not a removal.
+    c.put(3, 3);                    // evicts 1.
+    c.put(4, 4, std::chrono::milliseconds(10));   // evicts 2.
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    c.expire();                     // expires 4.
+    c.erase(3);
+    ASSERT_M(
+        removed.size() == 4
+            && removed[0] == std::make_pair(1, removal_cause::evicted)
+            && removed[1] == std::make_pair(2, removal_cause::evicted)
+            && removed[2] == std::make_pair(4, removal_cause::expired)
+            && removed[3] == std::make_pair(3, removal_cause::erased),
+        "cache removal listener is told of every removal and its cause"
+    );
+}
+
+void test_invalidate_tag()
+{
+    utils::cache<int, int> c(10);
+    for (int key=0; key<6; ++key)
+    {
+        c.put_tagged(key, key, key % 2);
+    }
+    c.put(6, 6);
+    c.invalidate_tag(1);
+    int val = 0;
+    ASSERT_M(
+        c.get(0, val) && c.get(2, val) && c.get(4, val) && c.get(6, val),
+        "cache keeps items of other tags and untagged items"
+    );
+    ASSERT_M(
+        !c.get(1, val) && !c.contains(3) && !c.peek(5),
+        "cache invalidate_tag makes items of the tag stale"
+    );
+    ASSERT_M(c.size() == 6, "cache erases a stale item found by get");
+    c.put_tagged(3, 30, 1);
+    ASSERT_M(c.get(3, val) && val == 30, "cache put after invalidate_tag is live");
+    c.invalidate_tag(7);            // never used; no effect.
+    ASSERT_M(c.get(0, val) && c.get(3, val), "cache invalidate of unused tag");
+}
+
+void test_large_tags()
+{
+    utils::cache<int, int> c(10);
+    const uint64_t tags[] = {0xFFFFFFFFFFFFull, 1ull << 40, 0xFFFFFFFFull};
+    for (int key=0; key<6; ++key)
+    {
+        c.put_tagged(key, key, tags[key % 3]);
+    }
+    c.invalidate_tag(1ull << 40);
+    c.invalidate_tag(1ull << 41);   // never used; no effect.
+    int val = 0;
+    ASSERT_M(
+        c.get(0, val) && c.get(2, val) && c.get(3, val) && c.get(5, val)
+            && !c.get(1, val) && !c.get(4, val),
+        "cache invalidates a tag of any value"
+    );
+    string details;
+    ASSERT_M(c.check_consistency(details), details);
+}
+
+void test_tag_churn()
+{
+    // a distinct hashed tag per put; tags are freed with their items.
+    utils::cache<int, int> c(100);
+    uint64_t seed = 11;
+    bool ok = true;
+    for (int i=0; ok && i<20000; ++i)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        int key = int((seed >> 40) % 300);
+        c.put_tagged(key, key, seed);
+        if (i % 7 == 0)
+        {
+            c.invalidate_tag(seed);
+            ok = !c.contains(key);
+        }
+        else if (i % 11 == 0)
+        {
+            c.erase(key);
+        }
+    }
+    string ignore;
+    ASSERT_M(
+        ok && c.size() <= 100 && c.check_consistency(ignore),
+        "cache consistent under tag churn"
+    );
+}
+
+void test_bump_generation()
+{
+    utils::cache<int, int> c(4);
+    std::vector<std::pair<int, removal_cause>> removed;
+    c.set_removal_listener([&removed](const int & key, const int &, removal_cause cause){
+        removed.emplace_back(key, cause);
+    });
+    for (int key=0; key<4; ++key)
+    {
+        c.put_tagged(key, key, 0);
+    }
+    c.bump_generation();
+    c.put(10, 10);                  // a stale item makes room.
+    int val = 0;
+    ASSERT_M(
+        !c.contains(0) && !c.contains(1) && !c.contains(2) && !c.contains(3)
+            && c.get(10, val),
+        "cache bump_generation makes every item stale"
+    );
+    c.put(11, 11);
+    c.put(12, 12);
+    c.put(13, 13);
+    ASSERT_M(
+        c.get(10, val) && c.get(11, val) && c.get(12, val) && c.get(13, val),
+        "cache reclaims stale items before ejecting live ones"
+    );
+    bool all_invalidated = removed.size() == 4;
+    for (const auto & r : removed)
+    {
+        all_invalidated = all_invalidated && r.first < 4
+            && r.second == removal_cause::invalidated;
+    }
+    ASSERT_M(all_invalidated, "cache tells the listener of invalidated items");
+    string details;
+    ASSERT_M(c.check_consistency(details), details);
+}
+
+void test_invalidation_churn()
+{
+    utils::cache<int, int> c(100);
+    unsigned seed = 7;
+    bool ok = true;
+    for (int i=0; ok && i<20000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        int key = int((seed >> 16) % 300);
+        int val = 0;
+        if (c.get(key, val))
+        {
+            ok = (val == key * 3);
+        }
+        else
+        {
+            c.put_tagged(key, key * 3, uint64_t(key % 5));
+        }
+        if (i % 100 == 0)
+        {
+            c.invalidate_tag((seed >> 8) % 5);
+        }
+        if (i % 1000 == 0)
+        {
+            c.bump_generation();
+        }
+    }
+    string ignore;
+    ASSERT_M(
+        ok && c.size() <= 100 && c.check_consistency(ignore),
+        "cache consistent under invalidation"
+    );
+}
+
+void test_save_load()
+{
+    const string path = "/tmp/test_cache_save_load.bin";
+    utils::cache<int, double> c(4);
+    for (int i=0; i<4; ++i)
+    {
+        c.put(i, i * 0.5);
+    }
+    double val = 0;
+    c.get(0, val);                  // 0 is now the most recent.
+    bool saved = c.save(path);
+
+    // room for only 3; the least recent, 1, is the one left out.
+    utils::cache<int, double> warm(3);
+    bool loaded = warm.load(path);
+    bool restored = !warm.contains(1) && warm.get(0, val) && val == 0.0
+        && warm.get(3, val) && val == 1.5;
+    warm.put(4, 2.0);               // ejects 2, the least recent left.
+    std::remove(path.c_str());
+    ASSERT_M(
+        saved && loaded && restored && !warm.contains(2) && warm.contains(3),
+        "cache save and load keep the lru order"
+    );
+}
+
+void test_save_load_ttl()
+{
+    const string path = "/tmp/test_cache_save_load_ttl.bin";
+    utils::cache<int, int> c(4);
+    c.put(1, 1, std::chrono::milliseconds(20));
+    c.put(2, 2, std::chrono::hours(1));
+    c.put(3, 3);
+    c.save(path);
+    utils::cache<int, int> warm(4);
+    warm.load(path);
+    std::remove(path.c_str());
+    bool loaded = warm.size() == 3;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int val = 0;
+    ASSERT_M(
+        loaded && !warm.get(1, val) && warm.get(2, val) && warm.get(3, val),
+        "cache save and load keep the time to live"
+    );
+}
+
+void test_load_bad_file()
+{
+    const string path = "/tmp/test_cache_load_bad_file.bin";
+    utils::cache<int, int> c(4);
+    c.put(1, 1);
+    c.save(path);
+    // a snapshot of different types is rejected.
+    utils::cache<int, double> other(4);
+    bool other_loaded = other.load(path);
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "not a cache";
+    }
+    utils::cache<int, int> warm(4);
+    bool garbage_loaded = warm.load(path);
+    std::remove(path.c_str());
+    bool missing_loaded = warm.load(path);
+    ASSERT_M(
+        !other_loaded && !garbage_loaded && !missing_loaded
+            && other.size() == 0 && warm.size() == 0,
+        "cache load rejects a file that is not its snapshot"
+    );
+}
+
+#if __cplusplus >= 201703L
+void test_transparent_lookup()
+{
+    using string_cache = utils::cache<
+        counted_string, string, lru_policy, flat_index, string_hash,
+        std::equal_to<>
+    >;
+    string_cache c(8);
+    c.put("http://abc.com/a/long/enough/url/not/to/fit/in/sso", "yak yak");
+    std::string_view key = "http://abc.com/a/long/enough/url/not/to/fit/in/sso";
+    std::string_view missing = "http://rextester.com/a/long/enough/url/not/in/sso";
+    auto before = allocations;
+    auto p = c.get(key);
+    bool found = p && *p == "yak yak" && c.contains(key) && !c.get(missing)
+        && c.get("http://abc.com/a/long/enough/url/not/to/fit/in/sso");
+    auto lookup_allocations = allocations - before;
+    bool erased = c.erase(key) && !c.contains(key);
+    ASSERT_M(
+        found && lookup_allocations == 0 && erased,
+        "cache lookup by string_view does not allocate"
+    );
+}
+#endif
+
 int main()
 {
     test_interface_basic();
@@ -93,6 +862,52 @@ int main()
     test_put_idempotent();
     test_capacity_eject_oldest();
     test_capacity_eject_lru();
+    test_capacity_churn<flat_index>("lru order under churn matches reference model, flat_index");
+    test_capacity_churn<swiss_index>("lru order under churn matches reference model, swiss_index");
+    test_zero_capacity();
+    test_clock_policy();
+    test_policy_churn<lru_policy>("lru consistent under churn");
+    test_policy_churn<clock_policy>("clock consistent under churn");
+    test_policy_churn<slru_policy>("slru consistent under churn");
+    test_policy_churn<two_q_policy>("2q consistent under churn");
+    test_policy_churn<arc_policy>("arc consistent under churn");
+    test_policy_churn<lfu_policy>("lfu consistent under churn");
+    test_slru_policy();
+    test_two_q_policy();
+    test_arc_policy();
+    test_lfu_policy();
+    test_erase_churn<lru_policy>("lru consistent under erase");
+    test_erase_churn<clock_policy>("clock consistent under erase");
+    test_erase_churn<slru_policy>("slru consistent under erase");
+    test_erase_churn<two_q_policy>("2q consistent under erase");
+    test_erase_churn<arc_policy>("arc consistent under erase");
+    test_erase_churn<lfu_policy>("lfu consistent under erase");
+    test_erase();
+    test_ttl_lazy_expiry();
+    test_ttl_put_clears_expiry();
+    test_ttl_reclaim_before_eject();
+    test_ttl_expire();
+    test_weight_budget();
+    test_weight_ejects_until_fit();
+    test_weight_rejects_too_heavy();
+    test_weight_update();
+    test_weight_reused_slots();
+    test_get_no_copy();
+    test_custom_hash();
+    test_multi_get();
+    test_multi_put();
+    test_removal_listener();
+    test_invalidate_tag();
+    test_large_tags();
+    test_tag_churn();
+    test_bump_generation();
+    test_invalidation_churn();
+    test_save_load();
+    test_save_load_ttl();
+    test_load_bad_file();
+#if __cplusplus >= 201703L
+    test_transparent_lookup();
+#endif
 
     std::cout << "\n done";
     //getchar();
@@ -0,0 +1,90 @@
+#include "cache_index.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// well mixed hash of a key, as cache gives it to the index.
+uint64_t mixed(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    return key ^ (key >> 33);
+}
+
+template<typename INDEX>
+void test_find_insert_erase(const char * what)
+{
+    // slot i holds key keys[i].
+    std::vector<uint64_t> keys{10, 20, 30};
+    INDEX index(3);
+    for (uint32_t s=0; s<keys.size(); ++s)
+    {
+        index.insert(mixed(keys[s]), s);
+    }
+    auto find = [&](uint64_t key){
+        return index.find(mixed(key), [&](uint32_t s){ return keys[s] == key; });
+    };
+    bool ok = find(10) == 0 && find(20) == 1 && find(30) == 2 && find(40) == INDEX::npos;
+    index.erase(mixed(20), 1);
+    ok = ok && find(20) == INDEX::npos && find(10) == 0 && find(30) == 2;
+    ASSERT_M(ok, what);
+}
+
+template<typename INDEX>
+void test_churn(uint32_t capacity, const char * what)
+{
+    // keep capacity of 5000 keys indexed, replacing one at a time, so that
+    // erase has to keep probe sequences intact.
+    INDEX index(capacity);
+    std::vector<uint64_t> keys(capacity);
+    std::unordered_map<uint64_t, uint32_t> model;
+    for (uint32_t s=0; s<capacity; ++s)
+    {
+        keys[s] = s;
+        index.insert(mixed(s), s);
+        model[s] = s;
+    }
+    bool ok = true;
+    uint64_t next = capacity;
+    unsigned seed = 11;
+    for (int i=0; ok && i<200000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint32_t s = (seed >> 8) % capacity;
+        index.erase(mixed(keys[s]), s);
+        model.erase(keys[s]);
+        keys[s] = next++ % 5000;
+        if (model.count(keys[s]))
+        {
+            // already indexed in another slot; leave this one as is.
+            keys[s] = next++ % 5000 + 5000;
+        }
+        index.insert(mixed(keys[s]), s);
+        model[keys[s]] = s;
+
+        uint64_t probe = (seed >> 4) % 10000;
+        auto found = index.find(mixed(probe), [&](uint32_t t){ return keys[t] == probe; });
+        auto itr = model.find(probe);
+        ok = (itr == model.end()) ? (found == INDEX::npos) : (found == itr->second);
+    }
+    ASSERT_M(ok, what);
+}
+
+int main()
+{
+    test_find_insert_erase<flat_index>("flat_index find insert erase");
+    test_find_insert_erase<swiss_index>("swiss_index find insert erase");
+    test_churn<flat_index>(1000, "flat_index under churn matches reference model");
+    test_churn<swiss_index>(1000, "swiss_index under churn matches reference model");
+    // high load, so that groups fill up and tombstones force rebuilds.
+    test_churn<flat_index>(24, "flat_index at high load");
+    test_churn<swiss_index>(24, "swiss_index at high load with rebuilds");
+
+    std::cout << "\n done";
+    //getchar();
+    return 0;
+}
@@ -0,0 +1,167 @@
+#define CACHE_STATS
+#include "cache.h"
+#include "concurrent_cache.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <chrono>
+#include <string>
+using std::string;
+#include <thread>
+#include <vector>
+
+void test_disabled_snapshot()
+{
+    cache_stats st;
+    ASSERT_M(
+        !st.enabled && st.hit_ratio() == 0 && st.window_hit_ratio() == 0,
+        "empty stats snapshot"
+    );
+}
+
+void test_counters()
+{
+    utils::cache<int, int> c(2);
+    int val = 0;
+    c.put(1, 1);        // insertion
+    c.put(2, 2);        // insertion
+    c.put(1, 10);       // update
+    c.get(1, val);      // hit
+    c.get(3, val);      // miss
+    c.put(3, 3);        // insertion, evicts 2
+    c.put(4, 4, std::chrono::milliseconds(10));     // insertion, evicts 1
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    c.get(4, val);      // miss, expiration
+    auto st = c.stats();
+    ASSERT_M(
+        st.enabled && st.hits == 1 && st.misses == 2 && st.insertions == 4
+            && st.updates == 1 && st.evictions == 2 && st.expirations == 1,
+        "cache counts hits, misses, insertions, updates, evictions, expirations"
+    );
+    ASSERT_M(st.hit_ratio() > 0.33 && st.hit_ratio() < 0.34, "cache hit ratio");
+}
+
+void test_invalidation_counter()
+{
+    utils::cache<int, int> c(2);
+    int val = 0;
+    c.put_tagged(1, 1, 0);
+    c.put(2, 2);
+    c.invalidate_tag(0);
+    c.get(1, val);      // miss, invalidation
+    c.bump_generation();
+    c.put(3, 3);        // insertion, 2 reclaimed as stale
+    c.put(4, 4);        // insertion
+    auto st = c.stats();
+    ASSERT_M(
+        st.invalidations == 2 && st.evictions == 0 && st.insertions == 4,
+        "cache counts invalidations apart from evictions"
+    );
+}
+
+void test_window_hit_ratio()
+{
+    utils::cache<int, int> c(100);
+    for (int key=0; key<100; ++key)
+    {
+        c.put(key, key);
+    }
+    int val = 0;
+    // a long run of misses, then a run of hits as long as the window.
+    for (int i=0; i<200000; ++i)
+    {
+        c.get(1000, val);
+    }
+    for (int i=0; i<200000; ++i)
+    {
+        c.get(i % 100, val);
+    }
+    auto st = c.stats();
+    ASSERT_M(
+        st.hit_ratio() > 0.49 && st.hit_ratio() < 0.51 && st.window_hit_ratio() > 0.99,
+        "window hit ratio follows recent lookups"
+    );
+}
+
+void test_concurrent_cache_stats()
+{
+    concurrent_cache<int, int> c(64, 4);
+    int val = 0;
+    for (int key=0; key<10; ++key)
+    {
+        c.put(key, key);
+        c.get(key, val);
+    }
+    c.put(0, 0);
+    auto shards = c.shard_stats();
+    uint64_t insertions = 0;
+    for (const auto & st : shards)
+    {
+        insertions += st.insertions;
+    }
+    auto total = c.get_stats();
+    ASSERT_M(
+        shards.size() == 4 && insertions == 10 && total.insertions == 10
+            && total.updates == 1 && total.hits == 10 && total.size == 10,
+        "concurrent_cache per shard and total stats"
+    );
+}
+
+void test_get_or_load_counts()
+{
+    concurrent_cache<int, int> c(64, 4);
+    auto loader = [](int key){ return key * 10; };
+    c.get_or_load(1, loader);     // miss, loads
+    c.get_or_load(1, loader);     // hit
+    auto st = c.get_stats();
+    ASSERT_M(
+        st.misses == 1 && st.hits == 1 && st.insertions == 1,
+        "concurrent_cache counts a get_or_load miss once"
+    );
+}
+
+template<typename POLICY>
+void test_concurrent_counts(const char * what)
+{
+    concurrent_cache<int, int, POLICY> c(1024, 16);
+    std::vector<std::thread> threads;
+    for (int t=0; t<4; ++t)
+    {
+        threads.emplace_back([&c, t](){
+            int val = 0;
+            for (int i=0; i<50000; ++i)
+            {
+                int key = (i * 7 + t) % 2048;
+                if (!c.get(key, val))
+                {
+                    c.put(key, key);
+                }
+            }
+        });
+    }
+    for (auto & th : threads)
+    {
+        th.join();
+    }
+    auto st = c.get_stats();
+    ASSERT_M(st.hits + st.misses == 200000, what);
+}
+
+int main()
+{
+    test_disabled_snapshot();
+    test_counters();
+    test_invalidation_counter();
+    test_window_hit_ratio();
+    test_concurrent_cache_stats();
+    test_get_or_load_counts();
+    test_concurrent_counts<lru_policy>("concurrent_cache counts every lookup");
+#if __cplusplus >= 201703L
+    // only C++17 takes shared locks for lookups.
+    test_concurrent_counts<clock_policy>("concurrent_cache counts shared lookups");
+#endif
+
+    std::cout << "\n done";
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "compressed_cache.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <chrono>
+#include <string>
+using std::string;
+#include <thread>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#endif
+
+string document(int id)
+{
+    string s = "{\"id\":" + std::to_string(id) + ",\"items\":[";
+    for (int i=0; i<40; ++i)
+    {
+        s += "{\"sku\":\"item-" + std::to_string(i) + "\",\"price\":"
+            + std::to_string(id % 50 + i) + ",\"in_stock\":true},";
+    }
+    s.back() = ']';
+    return s + "}";
+}
+
+void test_put_get()
+{
+    compressed_cache<int> c(100, 1 << 20);
+    c.put(1, document(1));
+    c.put(2, "short");
+    c.put(3, "");
+    string val = "previous";
+    ASSERT_M(c.get(1, val) && val == document(1), "compressed_cache large value");
+    ASSERT_M(c.get(2, val) && val == "short", "compressed_cache small value");
+    ASSERT_M(c.get(3, val) && val.empty(), "compressed_cache empty value");
+    ASSERT_M(!c.get(4, val) && !c.contains(4), "compressed_cache miss");
+    c.put(1, "updated");
+    ASSERT_M(c.get(1, val) && val == "updated", "compressed_cache update");
+    ASSERT_M(c.erase(2) && !c.contains(2) && c.size() == 2, "compressed_cache erase");
+    c.put(5, document(5), std::chrono::milliseconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ASSERT_M(!c.get(5, val), "compressed_cache ttl");
+}
+
+void test_threshold()
+{
+    compressed_cache<int> c(100, 1 << 20, 1 << 16);
+    auto doc = document(1);
+    c.put(1, doc);
+    ASSERT_M(c.stored_bytes() == doc.size() + 1, "compressed_cache below threshold is raw");
+    compressed_cache<int> z(100, 1 << 20, 64);
+    z.put(1, doc);
+    ASSERT_M(z.stored_bytes() * 2 < doc.size(), "compressed_cache above threshold");
+    string noise(1000, '\0');
+    unsigned seed = 1;
+    for (auto & ch : noise)
+    {
+        seed = seed * 1103515245 + 12345;
+        ch = char(seed >> 16);
+    }
+    z.put(2, noise);
+    string val;
+    ASSERT_M(
+        z.get(2, val) && val == noise && z.stored_bytes() < doc.size() + noise.size(),
+        "compressed_cache stores incompressible values raw"
+    );
+}
+
+void test_budget()
+{
+    auto doc_size = document(0).size();
+    // room for 10 documents uncompressed.
+    compressed_cache<int> c(1000, 10 * doc_size);
+    for (int id=0; id<1000; ++id)
+    {
+        c.put(id, document(id));
+    }
+    string val;
+    bool ok = true;
+    for (int id=1000 - int(c.size()); id<1000; ++id)
+    {
+        ok = ok && c.get(id, val) && val == document(id);
+    }
+    string details;
+    ASSERT_M(
+        c.size() >= 30 && c.stored_bytes() <= c.max_bytes() && ok
+            && c.check_consistency(details),
+        "compressed_cache fits several times more items in the budget"
+    );
+}
+
+// Return: bytes of heap in use, or 0 if not known, say under a sanitizer.
+size_t heap_in_use()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    auto mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+void test_budget_after_replace()
+{
+    string noise(100000, '\0');
+    unsigned seed = 3;
+    for (auto & ch : noise)
+    {
+        seed = seed * 1103515245 + 12345;
+        ch = char(seed >> 16);
+    }
+    auto before = heap_in_use();
+    {
+        // 100 incompressible values of 100 KB, then small ones in their slots.
+        compressed_cache<int> c(100, 100 * (noise.size() + 1));
+        for (int id=0; id<100; ++id)
+        {
+            noise[0] = char(id);
+            c.put(id, noise);
+        }
+        for (int id=100; id<10000; ++id)
+        {
+            c.put(id, document(id));
+        }
+        // the values, the slots and index, and the encoding buffers; 10 MB
+        // if the slots kept the old values' buffers.
+        auto held = heap_in_use() - before;
+        ASSERT_M(
+            c.size() == 100 && c.stored_bytes() < 100 * document(0).size()
+                && (before == 0 || held < (1 << 20)),
+            "compressed_cache holds no more than the budget after values shrink"
+        );
+    }
+}
+
+int main()
+{
+    test_put_get();
+    test_threshold();
+    test_budget();
+    test_budget_after_replace();
+
+    std::cout << "\n done";
+    return 0;
+}
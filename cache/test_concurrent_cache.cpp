@@ -0,0 +1,276 @@
+#include "concurrent_cache.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <string>
+using std::string;
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+void test_put_get()
+{
+    concurrent_cache<string, string> page_cache(64, 4);
+    page_cache.put("http://abc.com", "yak yak");
+    string cached_page;
+    auto isok = page_cache.get("http://abc.com", cached_page);
+    ASSERT_M(isok && cached_page == "yak yak", "concurrent_cache put get interface");
+    ASSERT_M(!page_cache.get("http://rextester.com", cached_page), "concurrent_cache miss");
+    string ignore;
+    ASSERT_M(page_cache.size() == 1 && page_cache.check_consistency(ignore), "concurrent_cache size");
+}
+
+void test_capacity()
+{
+    concurrent_cache<int, int> c(100, 8);
+    ASSERT_M(c.num_shards() == 8 && c.capacity() == 104, "concurrent_cache capacity share rounded up");
+    for (int i=0; i<1000; ++i)
+    {
+        c.put(i, i);
+    }
+    string ignore;
+    ASSERT_M(c.size() <= c.capacity() && c.check_consistency(ignore), "concurrent_cache size within capacity");
+}
+
+void test_stats()
+{
+    concurrent_cache<int, int> c(16, 4);
+    int val = 0;
+    c.put(1, 1);
+    c.get(1, val);
+    c.get(1, val);
+    c.get(2, val);
+    auto st = c.get_stats();
+    ASSERT_M(st.size == 1 && st.capacity == 16, "concurrent_cache aggregate stats");
+#ifndef CACHE_STATS
+    ASSERT_M(
+        !st.enabled && st.hits == 0 && st.misses == 0,
+        "concurrent_cache counts no hits without CACHE_STATS"
+    );
+#else
+    ASSERT_M(
+        st.enabled && st.hits == 2 && st.misses == 1,
+        "concurrent_cache counts hits and misses with CACHE_STATS"
+    );
+#endif
+    auto shards = c.shard_stats();
+    ASSERT_M(shards.size() == 4, "concurrent_cache per shard stats");
+}
+
+void test_ttl_erase()
+{
+    concurrent_cache<int, int> c(16, 4);
+    c.put(1, 1, std::chrono::milliseconds(20));
+    c.put(2, 2);
+    c.put(3, 3);
+    bool erased = c.erase(3);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    c.expire();
+    int val = 0;
+    ASSERT_M(
+        erased && c.size() == 1 && !c.get(1, val) && c.get(2, val),
+        "concurrent_cache ttl and erase"
+    );
+}
+
+void test_weight()
+{
+    concurrent_cache<int, string> c(
+        1000, 400,
+        [](const int &, const string & page){ return page.size(); },
+        4
+    );
+    bool ok = true;
+    for (int i=0; i<1000; ++i)
+    {
+        ok = c.put(i, string(size_t(i % 50), 'x')) && ok;
+    }
+    bool too_heavy = c.put(-1, string(101, 'x'));
+    auto st = c.get_stats();
+    string ignore;
+    ASSERT_M(
+        ok && !too_heavy && st.weight <= 400 && c.check_consistency(ignore),
+        "concurrent_cache weight within max weight shared by shards"
+    );
+}
+
+void test_get_handle()
+{
+    concurrent_cache<int, string> c(2, 1);
+    c.put(1, "yak yak");
+    auto handle = c.get(1);
+    c.put(2, "blah blah");
+    c.put(3, "yada yada");
+    ASSERT_M(
+        handle && *handle == "yak yak" && !c.get(1) && c.get(4) == nullptr,
+        "concurrent_cache handle outlives ejection"
+    );
+}
+
+void test_get_or_load_single_flight()
+{
+    concurrent_cache<int, string> c(64, 4);
+    std::atomic<int> loads{0};
+    auto loader = [&](int key){
+        ++loads;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return std::to_string(key);
+    };
+    std::vector<std::shared_ptr<const string>> results(8);
+    std::vector<std::thread> threads;
+    for (size_t t=0; t<results.size(); ++t)
+    {
+        threads.emplace_back([&, t]{ results[t] = c.get_or_load(42, loader); });
+    }
+    for (auto & th : threads)
+    {
+        th.join();
+    }
+    bool same = true;
+    for (const auto & r : results)
+    {
+        same = same && r && *r == "42";
+    }
+    ASSERT_M(
+        loads == 1 && same && *c.get_or_load(42, loader) == "42" && loads == 1,
+        "concurrent_cache get_or_load loads once for concurrent misses"
+    );
+}
+
+void test_get_or_load_exception()
+{
+    concurrent_cache<int, string> c(64, 4);
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t=0; t<4; ++t)
+    {
+        threads.emplace_back([&]{
+            try
+            {
+                c.get_or_load(7, [](int) -> string {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    throw std::runtime_error("load failed");
+                });
+            }
+            catch (const std::runtime_error &)
+            {
+                ++failures;
+            }
+        });
+    }
+    for (auto & th : threads)
+    {
+        th.join();
+    }
+    auto v = c.get_or_load(7, [](int){ return string("ok"); }, std::chrono::seconds(10));
+    ASSERT_M(failures == 4 && *v == "ok", "concurrent_cache get_or_load exception reaches all callers");
+}
+
+template<typename POLICY>
+void test_multi_get_put(const char * what)
+{
+    concurrent_cache<int, string, POLICY> c(256, 8);
+    std::vector<std::pair<int, string>> items;
+    for (int i=0; i<100; ++i)
+    {
+        items.emplace_back(i, std::to_string(i));
+    }
+    auto put = c.multi_put(items);
+    // every other key is missing.
+    std::vector<int> keys;
+    for (int i=0; i<200; i+=2)
+    {
+        keys.push_back(i);
+    }
+    std::vector<std::shared_ptr<const string>> vals;
+    auto found = c.multi_get(keys, vals);
+    bool match = vals.size() == keys.size();
+    for (size_t i=0; match && i<keys.size(); ++i)
+    {
+        match = (keys[i] < 100) ? vals[i] && *vals[i] == std::to_string(keys[i]) : !vals[i];
+    }
+    auto st = c.get_stats();
+    ASSERT_M(
+        put == 100 && found == 50 && match && st.size == 100,
+        what
+    );
+}
+
+#if __cplusplus >= 201703L
+void test_transparent_lookup()
+{
+    concurrent_cache<
+        string, string, lru_policy, string_hash, std::equal_to<>
+    > c(64, 4);
+    c.put("http://abc.com", "yak yak");
+    std::string_view key = "http://abc.com";
+    string val;
+    ASSERT_M(
+        c.get(key, val) && val == "yak yak" && c.contains(key)
+            && !c.contains(std::string_view("http://rextester.com")),
+        "concurrent_cache lookup by string_view"
+    );
+}
+#endif
+
+template<typename POLICY>
+void test_concurrency(const char * what)
+{
+    concurrent_cache<int, int, POLICY> c(1024, 16);
+    std::vector<std::thread> threads;
+    for (int t=0; t<4; ++t)
+    {
+        threads.emplace_back([&c, t](){
+            int val = 0;
+            for (int i=0; i<100000; ++i)
+            {
+                int key = (i * 7 + t) % 2048;
+                if (!c.get(key, val))
+                {
+                    c.put(key, key * 2);
+                }
+                else if (val != key * 2)
+                {
+                    FAIL_M("concurrent_cache value corrupted");
+                }
+            }
+        });
+    }
+    for (auto & th : threads)
+    {
+        th.join();
+    }
+    string ignore;
+    ASSERT_M(c.check_consistency(ignore), what);
+}
+
+int main()
+{
+    test_put_get();
+    test_capacity();
+    test_stats();
+    test_ttl_erase();
+    test_weight();
+    test_get_handle();
+    test_get_or_load_single_flight();
+    test_get_or_load_exception();
+    test_multi_get_put<lru_policy>("concurrent_cache multi_get and multi_put");
+    test_multi_get_put<clock_policy>("concurrent_cache multi_get shared with clock_policy");
+#if __cplusplus >= 201703L
+    test_transparent_lookup();
+#endif
+    test_concurrency<lru_policy>("concurrent_cache 4 threads");
+    test_concurrency<clock_policy>("concurrent_cache 4 threads with clock_policy");
+
+    std::cout << "\n done";
+    //getchar();
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include "disk_tier.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <string>
+using std::string;
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+
+struct page
+{
+    uint64_t id;
+    char text[56];
+};
+
+page make_page(uint64_t id)
+{
+    page p{id, {}};
+    std::snprintf(p.text, sizeof(p.text), "page %llu", (unsigned long long)id);
+    return p;
+}
+
+bool has_page(disk_tier<uint64_t, page> & d, uint64_t key, uint64_t id)
+{
+    page p;
+    return d.get(key, p) && p.id == id && string(p.text) == make_page(id).text;
+}
+
+void test_put_get()
+{
+    disk_tier<uint64_t, page> d("/tmp/test_disk_tier_put_get.bin", 100, 8);
+    // some records in the file, some still buffered.
+    for (uint64_t i=0; i<20; ++i)
+    {
+        d.put(i, make_page(i));
+    }
+    d.put(3, make_page(33));
+    bool all = d.is_open() && d.size() == 20 && d.records() == 21;
+    for (uint64_t i=0; all && i<20; ++i)
+    {
+        all = has_page(d, i, i == 3 ? 33 : i);
+    }
+    page p;
+    bool erased = d.erase(5) && !d.get(5, p) && !d.get(1000, p);
+    ASSERT_M(all && erased, "disk_tier put get and erase through buffer and file");
+}
+
+void test_capacity_drops_oldest()
+{
+    disk_tier<uint64_t, page> d("/tmp/test_disk_tier_capacity.bin", 10, 4);
+    for (uint64_t i=0; i<10; ++i)
+    {
+        d.put(i, make_page(i));
+    }
+    d.put(0, make_page(100));       // 0 is now the newest.
+    d.put(10, make_page(10));       // drops 1.
+    d.put(11, make_page(11));       // drops 2.
+    ASSERT_M(
+        d.size() == 10 && has_page(d, 0, 100) && !has_page(d, 1, 1)
+            && !has_page(d, 2, 2) && has_page(d, 3, 3) && has_page(d, 11, 11),
+        "disk_tier drops the oldest items past capacity"
+    );
+}
+
+void test_compact()
+{
+    const char * path = "/tmp/test_disk_tier_compact.bin";
+    disk_tier<uint64_t, page> d(path, 100, 16);
+    for (int round=0; round<5; ++round)
+    {
+        for (uint64_t i=0; i<100; ++i)
+        {
+            d.put(i, make_page(i * 10 + round));
+        }
+    }
+    d.erase(7);
+    d.compact();
+    bool all = d.records() == 99 && d.size() == 99;
+    for (uint64_t i=0; all && i<100; ++i)
+    {
+        all = (i == 7) ? !has_page(d, i, 74) : has_page(d, i, i * 10 + 4);
+    }
+    // the file holds only the live records.
+    std::FILE * f = std::fopen(path, "rb");
+    std::fseek(f, 0, SEEK_END);
+    auto size = std::ftell(f);
+    std::fclose(f);
+    ASSERT_M(
+        all && size == long(99 * d.record_size),
+        "disk_tier compact keeps the live records"
+    );
+}
+
+void test_background_compaction()
+{
+    disk_tier<uint64_t, page> d("/tmp/test_disk_tier_background.bin", 1000, 64);
+    // a writer overwriting keys and a reader, while the tier compacts.
+    std::atomic<bool> ok{true};
+    std::thread reader([&d, &ok](){
+        for (int i=0; i<20000; ++i)
+        {
+            page p;
+            auto key = uint64_t(i % 50);
+            if (d.get(key, p) && p.id % 1000 != key)
+            {
+                ok = false;
+            }
+        }
+    });
+    for (uint64_t round=0; round<100; ++round)
+    {
+        for (uint64_t i=0; i<50; ++i)
+        {
+            d.put(i, make_page(round * 1000 + i));
+        }
+    }
+    reader.join();
+    for (int i=0; i<1000 && d.records() > 1100; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    bool all = d.size() == 50;
+    for (uint64_t i=0; all && i<50; ++i)
+    {
+        all = has_page(d, i, 99000 + i);
+    }
+    ASSERT_M(
+        ok && all && d.compactions() >= 1,
+        "disk_tier compacts in the background while in use"
+    );
+}
+
+void test_unwritable_path()
+{
+    disk_tier<uint64_t, page> d("/nonexistent_dir/test_disk_tier.bin", 100, 4);
+    for (uint64_t i=0; i<20; ++i)
+    {
+        d.put(i, make_page(i));
+    }
+    page p;
+    bool none = true;
+    for (uint64_t i=0; i<20; ++i)
+    {
+        none = none && !d.get(i, p);
+    }
+    d.compact();
+    ASSERT_M(
+        !d.is_open() && none && d.size() == 0,
+        "disk_tier that cannot write misses every get"
+    );
+}
+
+int main()
+{
+    test_put_get();
+    test_capacity_drops_oldest();
+    test_compact();
+    test_background_compaction();
+    test_unwritable_path();
+
+    std::cout << "\n done";
+    return 0;
+}
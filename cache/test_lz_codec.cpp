@@ -0,0 +1,111 @@
+#include "lz_codec.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <string>
+using std::string;
+#include <cstdint>
+
+bool round_trip(const string & in)
+{
+    string packed, out = "junk";
+    lz_codec::compress(in.data(), in.size(), packed);
+    return lz_codec::decompress(packed.data(), packed.size(), out) && out == in;
+}
+
+string random_bytes(size_t size, unsigned seed)
+{
+    string s(size, '\0');
+    for (auto & c : s)
+    {
+        seed = seed * 1103515245 + 12345;
+        c = char(seed >> 16);
+    }
+    return s;
+}
+
+string json(size_t records)
+{
+    string s = "[";
+    for (size_t i=0; i<records; ++i)
+    {
+        s += "{\"id\":" + std::to_string(i) + ",\"name\":\"user"
+            + std::to_string(i * 7919 % 1000) + "\",\"active\":true,"
+            + "\"roles\":[\"reader\",\"writer\"],\"score\":"
+            + std::to_string(i * 31 % 100) + "},";
+    }
+    s.back() = ']';
+    return s;
+}
+
+void test_round_trip()
+{
+    ASSERT_M(round_trip(""), "lz_codec empty input");
+    ASSERT_M(round_trip("a") && round_trip("abcd") && round_trip("abcde"), "lz_codec short input");
+    ASSERT_M(round_trip(string(100000, 'x')), "lz_codec run of one byte");
+    ASSERT_M(round_trip(string(1000, 'x') + "abc"), "lz_codec run then literals");
+    ASSERT_M(round_trip(random_bytes(100000, 1)), "lz_codec random input");
+    ASSERT_M(round_trip(json(2000)), "lz_codec json");
+    // literal and match lengths around the extension byte boundaries.
+    bool ok = true;
+    for (size_t n : {14, 15, 16, 18, 19, 20, 268, 269, 270, 271, 525})
+    {
+        auto literals = random_bytes(n, unsigned(n));
+        ok = ok && round_trip(literals) && round_trip(literals + literals)
+            && round_trip(literals + string(n, 'y') + literals);
+    }
+    ASSERT_M(ok, "lz_codec lengths around 15 and 15 + 255");
+    // matches further back than the offset field can reach.
+    auto far = random_bytes(70000, 3);
+    ASSERT_M(round_trip(far + far), "lz_codec match past max offset");
+}
+
+void test_ratio()
+{
+    auto in = json(2000);
+    string packed;
+    lz_codec::compress(in.data(), in.size(), packed);
+    ASSERT_M(packed.size() * 3 < in.size(), "lz_codec compresses json 3 times");
+    auto noise = random_bytes(100000, 2);
+    lz_codec::compress(noise.data(), noise.size(), packed);
+    ASSERT_M(
+        packed.size() < noise.size() + noise.size() / 200,
+        "lz_codec grows random input little"
+    );
+}
+
+void test_corrupt()
+{
+    auto in = json(100);
+    string packed, out;
+    lz_codec::compress(in.data(), in.size(), packed);
+    bool ok = true;
+    // every truncation fails; a changed byte fails or decodes in bounds,
+    // which the sanitizers check.
+    for (size_t n=0; n<packed.size(); ++n)
+    {
+        ok = ok && !lz_codec::decompress(packed.data(), n, out);
+    }
+    for (size_t i=0; i<packed.size(); ++i)
+    {
+        auto bad = packed;
+        bad[i] = char(bad[i] ^ 0x5A);
+        lz_codec::decompress(bad.data(), bad.size(), out);
+    }
+    ASSERT_M(ok, "lz_codec rejects truncated input");
+    ASSERT_M(
+        !lz_codec::decompress("\xFF\xFF\xFF", 3, out),
+        "lz_codec rejects a bad size"
+    );
+}
+
+int main()
+{
+    test_round_trip();
+    test_ratio();
+    test_corrupt();
+
+    std::cout << "\n done";
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "mapped_file.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <string>
+using std::string;
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+void test_missing_file()
+{
+    mapped_file f("/tmp/test_mapped_file_missing.bin");
+    ASSERT_M(!f.is_open() && f.size() == 0 && !f.data(), "mapped_file of a missing file");
+}
+
+void test_read_contents()
+{
+    const string path = "/tmp/test_mapped_file_contents.bin";
+    const string text(10000, 'x');
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << text << "end";
+    }
+    bool ok;
+    {
+        mapped_file f(path);
+        ok = f.is_open() && f.size() == text.size() + 3
+            && std::memcmp(f.data(), text.data(), text.size()) == 0
+            && std::memcmp(f.data() + text.size(), "end", 3) == 0;
+    }
+    std::remove(path.c_str());
+    ASSERT_M(ok, "mapped_file reads the file contents");
+}
+
+void test_empty_file()
+{
+    const string path = "/tmp/test_mapped_file_empty.bin";
+    std::ofstream(path, std::ios::binary | std::ios::trunc).close();
+    bool ok;
+    {
+        mapped_file f(path);
+        ok = f.is_open() && f.size() == 0 && !f.data();
+    }
+    std::remove(path.c_str());
+    ASSERT_M(ok, "mapped_file of an empty file");
+}
+
+void test_random_access()
+{
+    const string path = "/tmp/test_mapped_file_random.bin";
+    string text;
+    for (int i=0; i<10000; ++i)
+    {
+        text += char('a' + i % 26);
+    }
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << text;
+    }
+    bool ok;
+    {
+        mapped_file f(path, mapped_file::access::random);
+        ok = f.is_open() && f.size() == text.size();
+        for (size_t i = 7919; ok && i < text.size() * 10; i += 7919)
+        {
+            ok = f.data()[i % text.size()] == text[i % text.size()];
+        }
+    }
+    std::remove(path.c_str());
+    ASSERT_M(ok, "mapped_file for random access reads the file contents");
+}
+
+int main()
+{
+    test_missing_file();
+    test_read_contents();
+    test_empty_file();
+    test_random_access();
+
+    std::cout << "\n done";
+    return 0;
+}
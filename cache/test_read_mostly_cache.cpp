@@ -0,0 +1,124 @@
+#include "read_mostly_cache.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <string>
+using std::string;
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+void test_put_get()
+{
+    read_mostly_cache<string, string> c(64);
+    c.put("http://abc.com", "yak yak");
+    c.put_all({{"a", "1"}, {"b", "2"}, {"a", "3"}});
+    string val;
+    bool found = c.get("http://abc.com", val) && val == "yak yak"
+        && c.get("a", val) && val == "3" && !c.get("c", val);
+    bool erased = c.erase("b") && !c.erase("b") && !c.contains("b");
+    string ignore;
+    ASSERT_M(
+        found && erased && c.size() == 2 && c.check_consistency(ignore),
+        "read_mostly_cache put get and erase"
+    );
+}
+
+void test_capacity_keeps_recent()
+{
+    read_mostly_cache<int, int> c(11);
+    std::vector<std::pair<int, int>> items;
+    for (int i=0; i<10; ++i)
+    {
+        items.emplace_back(i, i);
+    }
+    c.put_all(items);
+    c.put(100, 100);                // a new version, to stamp reads with.
+    int val = 0;
+    for (int i=0; i<5; ++i)
+    {
+        c.get(i, val);
+    }
+    c.put_all({{10, 10}, {11, 11}, {12, 12}, {13, 13}, {14, 14}});
+    bool recent = true;
+    for (int i=0; i<5; ++i)
+    {
+        recent = recent && c.contains(i) && c.contains(10 + i);
+    }
+    string ignore;
+    ASSERT_M(
+        recent && c.size() == 11 && c.contains(100) && !c.contains(5)
+            && c.check_consistency(ignore),
+        "read_mostly_cache drops the least recently read over capacity"
+    );
+}
+
+void test_readers_and_writer()
+{
+    // values are key + version, so a reader sees a torn or freed item as
+    // a wrong value.
+    read_mostly_cache<int, std::pair<int, int>> c(1000);
+    std::atomic<bool> stop{false};
+    std::atomic<bool> ok{true};
+    std::atomic<size_t> reads{0};
+    std::atomic<int> started{0};
+    std::vector<std::thread> readers;
+    for (int t=0; t<4; ++t)
+    {
+        readers.emplace_back([&c, &stop, &ok, &reads, &started, t](){
+            std::pair<int, int> val;
+            size_t n = 0;
+            for (int i=0; i == 0 || !stop; ++i, ++n)
+            {
+                int key = (i * 7 + t) % 500;
+                if (c.get(key, val) && val.first != key)
+                {
+                    ok = false;
+                }
+                if (i == 0)
+                {
+                    ++started;
+                }
+            }
+            reads += n;
+        });
+    }
+    // start writing once every reader is reading, so the writer cannot
+    // finish before any of them is scheduled.
+    while (started < 4)
+    {
+        std::this_thread::yield();
+    }
+    for (int version=0; version<200; ++version)
+    {
+        std::vector<std::pair<int, std::pair<int, int>>> items;
+        for (int key=version % 2; key<500; key+=2)
+        {
+            items.emplace_back(key, std::make_pair(key, version));
+        }
+        c.put_all(items);
+        c.erase(version % 500);
+    }
+    stop = true;
+    for (auto & th : readers)
+    {
+        th.join();
+    }
+    string ignore;
+    ASSERT_M(
+        ok && reads > 0 && c.check_consistency(ignore),
+        "read_mostly_cache readers during writes"
+    );
+}
+
+int main()
+{
+    test_put_get();
+    test_capacity_keeps_recent();
+    test_readers_and_writer();
+
+    std::cout << "\n done";
+    return 0;
+}
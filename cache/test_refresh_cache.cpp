@@ -0,0 +1,144 @@
+#include "refresh_cache.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <string>
+using std::string;
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using std::chrono::milliseconds;
+
+// Return: true if pred() turns true within a second.
+template<typename PRED>
+bool eventually(PRED pred)
+{
+    for (int i=0; i<1000; ++i)
+    {
+        if (pred())
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return false;
+}
+
+void test_load_on_miss(thread_pool & pool)
+{
+    std::atomic<int> loads{0};
+    refresh_cache<int, string> c(
+        pool, [&loads](const int & key){ ++loads; return std::to_string(key); },
+        std::chrono::seconds(10), std::chrono::seconds(20)
+    );
+    auto v1 = c.get(7);
+    auto v2 = c.get(7);
+    ASSERT_M(*v1 == "7" && *v2 == "7" && loads == 1, "refresh_cache loads on a miss only");
+}
+
+void test_stale_while_refresh(thread_pool & pool)
+{
+    std::atomic<int> loads{0};
+    refresh_cache<int, int> c(
+        pool, [&loads](const int &){ return ++loads; },
+        milliseconds(20), std::chrono::seconds(10)
+    );
+    auto first = *c.get(1);
+    std::this_thread::sleep_for(milliseconds(40));
+    // all stale gets return at once with the old value, and post one reload.
+    bool stale = true;
+    for (int i=0; i<100; ++i)
+    {
+        stale = stale && (*c.get(1) == 1 || loads == 2);
+    }
+    bool refreshed = eventually([&c](){ return *c.get(1) == 2; });
+    ASSERT_M(
+        first == 1 && stale && refreshed && loads == 2 && c.refreshes() == 1,
+        "refresh_cache serves the stale value while it reloads once"
+    );
+}
+
+void test_hard_ttl_blocks(thread_pool & pool)
+{
+    std::atomic<int> loads{0};
+    refresh_cache<int, int> c(
+        pool, [&loads](const int &){ return ++loads; },
+        milliseconds(10), milliseconds(20)
+    );
+    c.get(1);
+    std::this_thread::sleep_for(milliseconds(40));
+    ASSERT_M(*c.get(1) == 2, "refresh_cache reloads in the foreground past the hard ttl");
+}
+
+void test_refresh_failure(thread_pool & pool)
+{
+    std::atomic<int> loads{0};
+    std::atomic<bool> fail{false};
+    refresh_cache<int, int> c(
+        pool,
+        [&loads, &fail](const int &){
+            if (fail)
+            {
+                throw std::runtime_error("load failed");
+            }
+            return ++loads;
+        },
+        milliseconds(10), std::chrono::seconds(10)
+    );
+    c.get(1);
+    fail = true;
+    std::this_thread::sleep_for(milliseconds(20));
+    c.get(1);
+    bool failed = eventually([&c](){ return c.refresh_failures() == 1; });
+    // still served, and the next get posts a reload again.
+    bool stale = *c.get(1) == 1;
+    fail = false;
+    bool refreshed = eventually([&c](){ return *c.get(1) == 2; });
+    ASSERT_M(failed && stale && refreshed, "refresh_cache keeps the stale value when a reload throws");
+}
+
+void test_concurrency(thread_pool & pool)
+{
+    std::atomic<int> loads{0};
+    refresh_cache<int, int> c(
+        pool, [&loads](const int & key){ ++loads; return key * 2; },
+        milliseconds(1), milliseconds(50), 256, 8
+    );
+    std::vector<std::thread> threads;
+    std::atomic<bool> corrupted{false};
+    for (int t=0; t<4; ++t)
+    {
+        threads.emplace_back([&c, &corrupted, t](){
+            for (int i=0; i<20000; ++i)
+            {
+                int key = (i * 7 + t) % 300;
+                if (*c.get(key) != key * 2)
+                {
+                    corrupted = true;
+                }
+            }
+        });
+    }
+    for (auto & th : threads)
+    {
+        th.join();
+    }
+    string ignore;
+    ASSERT_M(!corrupted && c.check_consistency(ignore), "refresh_cache 4 threads");
+}
+
+int main()
+{
+    thread_pool pool(2);
+    test_load_on_miss(pool);
+    test_stale_while_refresh(pool);
+    test_hard_ttl_blocks(pool);
+    test_refresh_failure(pool);
+    test_concurrency(pool);
+
+    std::cout << "\n done";
+    return 0;
+}
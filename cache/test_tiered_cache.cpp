@@ -0,0 +1,99 @@
+#include "tiered_cache.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <string>
+using std::string;
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+void test_spill_and_promote()
+{
+    tiered_cache<int, double> c(10, "/tmp/test_tiered_cache_spill.bin", 100);
+    for (int i=0; i<50; ++i)
+    {
+        c.put(i, i * 0.5);
+    }
+    bool spilled = c.memory_size() == 10 && c.disk_size() == 40;
+    double val = 0;
+    bool promoted = c.get(3, val) && val == 1.5 && c.disk_hits() == 1
+        && c.memory_size() == 10 && c.disk_size() == 40;
+    // 3 was promoted, so it is in memory now.
+    bool in_memory = c.get(3, val) && c.disk_hits() == 1;
+    ASSERT_M(spilled && promoted && in_memory, "tiered_cache spills evictions and promotes disk hits");
+}
+
+void test_put_erase()
+{
+    tiered_cache<int, int> c(2, "/tmp/test_tiered_cache_put_erase.bin", 10);
+    c.put(1, 1);
+    c.put(2, 2);
+    c.put(3, 3);                    // 1 spills.
+    c.put(1, 10);                   // the copy on disk is stale.
+    int val = 0;
+    bool updated = c.get(1, val) && val == 10;
+    bool erased = c.erase(2) && c.erase(3) && !c.get(2, val) && !c.get(3, val);
+    ASSERT_M(updated && erased && c.disk_size() == 0, "tiered_cache put and erase cover both tiers");
+}
+
+void test_larger_effective_capacity()
+{
+    tiered_cache<uint64_t, uint64_t> c(100, "/tmp/test_tiered_cache_capacity.bin", 10000);
+    for (uint64_t i=0; i<5000; ++i)
+    {
+        c.put(i, i * 3);
+    }
+    size_t hits = 0;
+    uint64_t val = 0;
+    for (uint64_t i=0; i<5000; ++i)
+    {
+        hits += c.get(i, val) && val == i * 3;
+    }
+    string ignore;
+    ASSERT_M(hits == 5000 && c.check_consistency(ignore), "tiered_cache keeps 50 times its memory capacity");
+}
+
+void test_concurrency()
+{
+    tiered_cache<int, int> c(64, "/tmp/test_tiered_cache_threads.bin", 2000);
+    std::vector<std::thread> threads;
+    std::atomic<bool> ok{true};
+    for (int t=0; t<4; ++t)
+    {
+        threads.emplace_back([&c, &ok, t](){
+            int val = 0;
+            for (int i=0; i<20000; ++i)
+            {
+                int key = (i * 7 + t) % 1000;
+                if (!c.get(key, val))
+                {
+                    c.put(key, key * 2);
+                }
+                else if (val != key * 2)
+                {
+                    ok = false;
+                }
+            }
+        });
+    }
+    for (auto & th : threads)
+    {
+        th.join();
+    }
+    string ignore;
+    ASSERT_M(ok && c.check_consistency(ignore), "tiered_cache 4 threads");
+}
+
+int main()
+{
+    test_spill_and_promote();
+    test_put_erase();
+    test_larger_effective_capacity();
+    test_concurrency();
+
+    std::cout << "\n done";
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "timing_wheel.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <chrono>
+using std::chrono::milliseconds;
+#include <cstdint>
+#include <vector>
+
+using time_point = timing_wheel::clock::time_point;
+
+void test_fire_on_time()
+{
+    auto start = time_point{};
+    timing_wheel wheel(1000, milliseconds(1), start);
+    // expiry in ms of each id, spread over all the wheels.
+    std::vector<int64_t> expiry(1000);
+    unsigned seed = 7;
+    for (uint32_t id=0; id<1000; ++id)
+    {
+        seed = seed * 1103515245 + 12345;
+        expiry[id] = int64_t(1) + (seed >> 8) % (int64_t(1) << (id % 4 * 6 + 6));
+        wheel.schedule(id, start + milliseconds(expiry[id]));
+    }
+    bool ok = wheel.size() == 1000;
+    size_t fired = 0;
+    int64_t prev = 0;
+    for (int64_t now = 0; now < (int64_t(1) << 25); now += 1 + now / 7)
+    {
+        wheel.advance(start + milliseconds(now), [&](uint32_t id){
+            ok = ok && expiry[id] > prev && expiry[id] <= now;
+            ++fired;
+        });
+        prev = now;
+    }
+    ASSERT_M(ok && fired == 1000 && wheel.size() == 0, "timing wheel fires each id on time");
+}
+
+void test_cancel_reschedule()
+{
+    auto start = time_point{};
+    timing_wheel wheel(4, milliseconds(10), start);
+    wheel.schedule(0, start + milliseconds(100));
+    wheel.schedule(1, start + milliseconds(100));
+    wheel.schedule(2, start + milliseconds(100));
+    wheel.cancel(1);
+    wheel.schedule(2, start + milliseconds(5000));
+    std::vector<uint32_t> fired;
+    wheel.advance(start + milliseconds(1000), [&](uint32_t id){ fired.push_back(id); });
+    ASSERT_M(
+        fired.size() == 1 && fired[0] == 0 && !wheel.scheduled(1) && wheel.scheduled(2),
+        "timing wheel cancel and reschedule"
+    );
+}
+
+void test_rounds_up()
+{
+    auto start = time_point{};
+    timing_wheel wheel(1, milliseconds(10), start);
+    wheel.schedule(0, start + milliseconds(15));
+    bool early = false, fired = false;
+    wheel.advance(start + milliseconds(19), [&](uint32_t){ early = true; });
+    wheel.advance(start + milliseconds(20), [&](uint32_t){ fired = true; });
+    ASSERT_M(!early && fired, "timing wheel never fires early");
+}
+
+void test_beyond_range()
+{
+    auto start = time_point{};
+    timing_wheel wheel(1, milliseconds(1), start);
+    // past the 64^4 ticks the wheels cover.
+    int64_t expiry = (int64_t(1) << 25) + 12345;
+    wheel.schedule(0, start + milliseconds(expiry));
+    int64_t fired_at = -1;
+    for (int64_t now = 0; fired_at < 0 && now < 2 * expiry; now += 1000)
+    {
+        wheel.advance(start + milliseconds(now), [&](uint32_t){ fired_at = now; });
+    }
+    ASSERT_M(fired_at >= expiry && fired_at < expiry + 1000, "timing wheel expiry beyond its range");
+}
+
+void test_expired_callback_reschedules()
+{
+    auto start = time_point{};
+    timing_wheel wheel(1, milliseconds(1), start);
+    wheel.schedule(0, start + milliseconds(10));
+    size_t fired = 0;
+    for (int64_t now = 1; now <= 100; ++now)
+    {
+        wheel.advance(start + milliseconds(now), [&](uint32_t id){
+            ++fired;
+            wheel.schedule(id, start + milliseconds(now + 10));
+        });
+    }
+    ASSERT_M(fired == 10, "timing wheel callback can reschedule");
+}
+
+void test_idle_gap()
+{
+    auto start = time_point{};
+    timing_wheel wheel(3, milliseconds(1), start);
+    // far expiries pending across a gap of 2^30 ticks, about 12 days.
+    int64_t gap = int64_t(1) << 30;
+    wheel.schedule(0, start + milliseconds(3600 * 1000));
+    wheel.schedule(1, start + milliseconds(gap + 5));
+    wheel.schedule(2, start + milliseconds(gap * 2));
+    std::vector<int> fired;
+    auto begin = std::chrono::steady_clock::now();
+    wheel.advance(start + milliseconds(gap), [&](uint32_t id){ fired.push_back(int(id)); });
+    auto took = std::chrono::steady_clock::now() - begin;
+    bool first = fired.size() == 1 && fired[0] == 0;
+    wheel.advance(start + milliseconds(gap + 5), [&](uint32_t id){ fired.push_back(int(id)); });
+    ASSERT_M(
+        first && fired.size() == 2 && fired[1] == 1 && wheel.size() == 1,
+        "timing wheel fires on time across an idle gap"
+    );
+    // stepping every tick would take seconds.
+    ASSERT_M(took < std::chrono::milliseconds(200), "timing wheel skips idle ticks");
+}
+
+int main()
+{
+    test_fire_on_time();
+    test_cancel_reschedule();
+    test_rounds_up();
+    test_beyond_range();
+    test_expired_callback_reschedules();
+    test_idle_gap();
+
+    std::cout << "\n done";
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include "cache.h"
+#include "tinylfu_policy.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <string>
+using std::string;
+#include <cstdint>
+
+uint64_t mix(uint64_t i)
+{
+    i *= 0x9E3779B97F4A7C15ull;
+    return i ^ (i >> 29);
+}
+
+void test_sketch_counts()
+{
+    frequency_sketch sketch(1000);
+    for (int i=0; i<5; ++i)
+    {
+        sketch.increment(mix(1));
+    }
+    sketch.increment(mix(2));
+    ASSERT_M(
+        sketch.frequency(mix(1)) == 5 && sketch.frequency(mix(2)) == 1
+            && sketch.frequency(mix(3)) == 0,
+        "frequency sketch counts sightings, first one in the doorkeeper"
+    );
+}
+
+void test_sketch_saturates_and_ages()
+{
+    frequency_sketch sketch(1000);
+    for (int i=0; i<100; ++i)
+    {
+        sketch.increment(mix(1));
+    }
+    auto saturated = sketch.frequency(mix(1));
+    sketch.age();
+    ASSERT_M(
+        saturated == 16 && sketch.frequency(mix(1)) == 7,
+        "frequency sketch saturates and halves on aging"
+    );
+}
+
+void test_sketch_ages_periodically()
+{
+    frequency_sketch sketch(16);
+    for (int i=0; i<10; ++i)
+    {
+        sketch.increment(mix(1));
+    }
+    // other keys push the sketch past its sample size.
+    for (uint64_t i=100; i<400; ++i)
+    {
+        sketch.increment(mix(i));
+    }
+    ASSERT_M(sketch.frequency(mix(1)) < 10, "frequency sketch ages periodically");
+}
+
+// get the key, put it on a miss.
+template<typename CACHE>
+bool access(CACHE & c, int key)
+{
+    int val = 0;
+    if (c.get(key, val))
+    {
+        return true;
+    }
+    c.put(key, key);
+    return false;
+}
+
+// Return: hit ratio of hot keys, with a scan of one-off keys in between.
+template<typename POLICY>
+double hot_hit_ratio_with_scan()
+{
+    utils::cache<int, int, POLICY> c(100);
+    unsigned seed = 7;
+    int scan_key = 1000000;
+    size_t hits = 0, gets = 0;
+    for (int i=0; i<40000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        int hot_key = (seed >> 16) % 60;
+        bool hit = access(c, hot_key);
+        if (i >= 10000)
+        {
+            hits += hit;
+            ++gets;
+        }
+        access(c, scan_key++);
+        access(c, scan_key++);
+    }
+    return double(hits) / gets;
+}
+
+void test_scan_resistance()
+{
+    auto lru = hot_hit_ratio_with_scan<lru_policy>();
+    auto tinylfu = hot_hit_ratio_with_scan<tinylfu_policy>();
+    ASSERT_M(tinylfu > 0.9 && tinylfu > lru + 0.3, "tinylfu keeps hot keys through a scan");
+}
+
+// Return: hit ratio of a loop over more keys than the cache holds.
+template<typename POLICY>
+double loop_hit_ratio()
+{
+    utils::cache<int, int, POLICY> c(1000);
+    size_t hits = 0;
+    for (int i=0; i<400000; ++i)
+    {
+        hits += access(c, i % 5000);
+    }
+    return double(hits) / 400000;
+}
+
+void test_loop()
+{
+    auto lru = loop_hit_ratio<lru_policy>();
+    auto tinylfu = loop_hit_ratio<tinylfu_policy>();
+    ASSERT_M(tinylfu > 0.1 && tinylfu > lru + 0.1, "tinylfu keeps part of a loop");
+}
+
+void test_recency()
+{
+    // a new key hit in a burst while it is in the window is kept.
+    utils::cache<int, int, tinylfu_policy> c(10);
+    int val = 0;
+    for (int i=0; i<100; ++i)
+    {
+        access(c, i);
+    }
+    c.put(-1, -1);
+    ASSERT_M(c.get(-1, val) && val == -1, "tinylfu admits new key to the window");
+}
+
+void test_churn_consistency()
+{
+    utils::cache<int, int, tinylfu_policy> c(64);
+    unsigned seed = 7;
+    for (int i=0; i<20000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        // skewed keys, so both admission outcomes happen often.
+        int key = int(((seed >> 16) % 300) * ((seed >> 8) % 300) / 300);
+        access(c, key);
+    }
+    string ignore;
+    ASSERT_M(c.size() == 64 && c.check_consistency(ignore), "tinylfu consistent under churn");
+}
+
+void test_tiny_capacity()
+{
+    utils::cache<int, int, tinylfu_policy> c(1);
+    for (int i=0; i<10; ++i)
+    {
+        access(c, i % 3);
+    }
+    string ignore;
+    ASSERT_M(c.size() == 1 && c.check_consistency(ignore), "tinylfu with capacity 1");
+}
+
+int main()
+{
+    test_sketch_counts();
+    test_sketch_saturates_and_ages();
+    test_sketch_ages_periodically();
+    test_scan_resistance();
+    test_loop();
+    test_recency();
+    test_churn_consistency();
+    test_tiny_capacity();
+
+    std::cout << "\n done";
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include "write_behind_cache.h"
+#include "../test/test.h"
+using namespace utils;
+#include <iostream>
+using std::cout;
+#include <string>
+using std::string;
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using std::chrono::milliseconds;
+
+// A backing store that records the batches written to it.
+struct store
+{
+    using batch_type = std::vector<std::pair<int, int>>;
+
+    void write(const batch_type & batch)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        if (_fail)
+        {
+            throw std::runtime_error("store down");
+        }
+        ++_batches;
+        for (const auto & kv : batch)
+        {
+            _data[kv.first] = kv.second;
+            ++_writes;
+        }
+    }
+
+    std::mutex _mutex;
+    std::map<int, int> _data;
+    size_t _batches = 0;
+    size_t _writes = 0;
+    bool _fail = false;
+};
+
+void test_flush_coalesces()
+{
+    store st;
+    write_behind_cache<int, int> c(
+        100, [&st](const store::batch_type & b){ st.write(b); }, std::chrono::hours(1)
+    );
+    for (int i=0; i<10; ++i)
+    {
+        for (int key=0; key<5; ++key)
+        {
+            c.put(key, i);
+        }
+    }
+    auto dirty = c.dirty();
+    c.flush();
+    int val = 0;
+    ASSERT_M(
+        dirty == 5 && c.dirty() == 0 && st._batches == 1 && st._writes == 5
+            && st._data[3] == 9 && c.get(3, val) && val == 9,
+        "write_behind_cache flush writes the latest value of each key once"
+    );
+}
+
+void test_evicted_dirty_kept()
+{
+    store st;
+    write_behind_cache<int, int> c(
+        4, [&st](const store::batch_type & b){ st.write(b); }, std::chrono::hours(1)
+    );
+    for (int key=0; key<10; ++key)
+    {
+        c.put(key, key * 10);
+    }
+    c.erase(9);
+    bool nothing_written = st._writes == 0;
+    c.flush();
+    bool all = st._data.size() == 10;
+    for (int key=0; all && key<10; ++key)
+    {
+        all = st._data[key] == key * 10;
+    }
+    ASSERT_M(
+        nothing_written && all && c.size() == 3,
+        "write_behind_cache writes dirty items evicted or erased"
+    );
+}
+
+void test_read_evicted_dirty()
+{
+    store st;
+    write_behind_cache<int, int> c(
+        2, [&st](const store::batch_type & b){ st.write(b); }, std::chrono::hours(1)
+    );
+    c.put(1, 10);
+    c.put(2, 20);
+    c.put(3, 30);                   // evicts 1, not yet written.
+    int val = 0;
+    bool read_back = c.get(1, val) && val == 10 && st._writes == 0;
+    c.flush();
+    ASSERT_M(
+        read_back && !c.get(1, val) && st._data[1] == 10,
+        "write_behind_cache get finds a dirty item evicted before its write"
+    );
+}
+
+void test_rejected_put_kept()
+{
+    store st;
+    write_behind_cache<int, int> c(
+        0, [&st](const store::batch_type & b){ st.write(b); }, std::chrono::hours(1)
+    );
+    c.put(1, 10);
+    c.put(1, 11);
+    int val = 0;
+    bool kept = c.get(1, val) && val == 11 && c.dirty() == 1 && c.size() == 0;
+    c.flush();
+    ASSERT_M(
+        kept && c.dirty() == 0 && st._writes == 1 && st._data[1] == 11,
+        "write_behind_cache writes an item the cache rejects"
+    );
+}
+
+void test_background_batches()
+{
+    store st;
+    {
+        write_behind_cache<int, int> c(
+            8, [&st](const store::batch_type & b){ st.write(b); },
+            std::chrono::hours(1), 16
+        );
+        // evictions reach the batch size and wake the writer.
+        for (int key=0; key<100; ++key)
+        {
+            c.put(key, key);
+        }
+        for (int i=0; i<1000 && c.dirty() > 16; ++i)
+        {
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+        std::lock_guard<std::mutex> l{st._mutex};
+        ASSERT_M(
+            st._batches >= 1 && st._batches < 20,
+            "write_behind_cache writes evicted items in batches"
+        );
+    }
+    ASSERT_M(st._data.size() == 100, "write_behind_cache writes the rest at destruction");
+}
+
+void test_interval()
+{
+    store st;
+    write_behind_cache<int, int> c(
+        100, [&st](const store::batch_type & b){ st.write(b); }, milliseconds(10)
+    );
+    c.put(1, 1);
+    bool written = false;
+    for (int i=0; i<1000 && !written; ++i)
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+        std::lock_guard<std::mutex> l{st._mutex};
+        written = st._data.count(1) == 1;
+    }
+    ASSERT_M(written && c.dirty() == 0, "write_behind_cache writes every interval");
+}
+
+void test_write_failure()
+{
+    store st;
+    write_behind_cache<int, int> c(
+        2, [&st](const store::batch_type & b){ st.write(b); }, std::chrono::hours(1)
+    );
+    c.put(1, 1);
+    c.put(2, 2);
+    st._fail = true;
+    bool threw = false;
+    try
+    {
+        c.flush();
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    // 1 is put again and 2 evicted while the batch is dirty again.
+    c.put(1, 10);
+    c.put(3, 3);
+    auto dirty = c.dirty();
+    st._fail = false;
+    c.flush();
+    ASSERT_M(
+        threw && dirty == 3 && st._data.size() == 3 && st._data[1] == 10
+            && st._data[2] == 2 && st._data[3] == 3,
+        "write_behind_cache retries a failed batch"
+    );
+}
+
+void test_concurrency()
+{
+    store st;
+    {
+        write_behind_cache<int, int> c(
+            64, [&st](const store::batch_type & b){ st.write(b); }, milliseconds(1), 8
+        );
+        std::vector<std::thread> threads;
+        for (int t=0; t<4; ++t)
+        {
+            threads.emplace_back([&c, t](){
+                int val = 0;
+                for (int i=0; i<20000; ++i)
+                {
+                    int key = (i * 7 + t) % 500;
+                    if (!c.get(key, val))
+                    {
+                        c.put(key, key);
+                    }
+                }
+            });
+        }
+        for (auto & th : threads)
+        {
+            th.join();
+        }
+        string ignore;
+        ASSERT_M(c.check_consistency(ignore), "write_behind_cache 4 threads");
+    }
+    bool all = st._data.size() == 500;
+    for (const auto & kv : st._data)
+    {
+        all = all && kv.first == kv.second;
+    }
+    ASSERT_M(all, "write_behind_cache 4 threads writes every key");
+}
+
+int main()
+{
+    test_flush_coalesces();
+    test_evicted_dirty_kept();
+    test_read_evicted_dirty();
+    test_rejected_put_kept();
+    test_background_batches();
+    test_interval();
+    test_write_failure();
+    test_concurrency();
+
+    std::cout << "\n done";
+    return 0;
+}
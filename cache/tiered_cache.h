@@ -0,0 +1,153 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A two tier cache in C++11: a cache in memory in front of a disk_tier.
+//      Items evicted from memory spill to disk instead of being lost, and a
+//      get that misses memory but hits disk promotes the item back.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "cache.h"
+#include "disk_tier.h"
+
+/*
+Notes:
+1.  An item is in one tier at a time. Eviction from memory moves it to disk,
+    a disk hit moves it back to memory, which may spill another item.
+2.  Only evicted items spill. An erased item is gone from both tiers, and
+    put of a key drops a copy on disk. There is no ttl, since the disk tier
+    does not keep expiry times.
+3.  For trivially copyable KEY and VAL only, as for disk_tier.
+4.  Thread safe; every operation takes one mutex, and the disk tier
+    compacts in its own thread.
+*/
+namespace utils
+{
+
+template<
+    typename KEY, typename VAL,
+    typename POLICY = lru_policy, typename HASH = std::hash<KEY>,
+    typename KEYEQ = std::equal_to<KEY>
+>
+class tiered_cache
+{
+    using memory_type = cache<KEY, VAL, POLICY, flat_index, HASH, KEYEQ>;
+    using disk_type = disk_tier<KEY, VAL, HASH, KEYEQ>;
+
+public:
+    // Params:
+    //        memory_capacity: maximum number of items in memory.
+    //        path: file the disk tier spills to.
+    //        disk_capacity: maximum number of items on disk.
+    tiered_cache(size_t memory_capacity, const std::string & path, size_t disk_capacity) :
+        _memory(memory_capacity),
+        _disk(path, disk_capacity),
+        _disk_hits(0)
+    {
+        _memory.set_removal_listener(
+            [this](const KEY & key, const VAL & val, removal_cause cause){
+                if (cause == removal_cause::evicted)
+                {
+                    _disk.put(key, val);
+                }
+                else
+                {
+                    _disk.erase(key);
+                }
+            }
+        );
+    }
+
+    // if found in either tier, copies to val and return true.
+    bool get(const KEY & key, VAL & val)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        if (_memory.get(key, val))
+        {
+            return true;
+        }
+        if (!_disk.get(key, val))
+        {
+            return false;
+        }
+        _disk.erase(key);
+        _memory.put(key, val);
+        _disk_hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void put(const KEY & key, const VAL & val)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        _disk.erase(key);
+        _memory.put(key, val);
+    }
+
+    // Return: true if key was in either tier.
+    bool erase(const KEY & key)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        bool in_memory = _memory.erase(key);
+        return _disk.erase(key) || in_memory;
+    }
+
+    // Return: number of items in memory.
+    size_t memory_size()
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _memory.size();
+    }
+
+    // Return: number of items on disk.
+    size_t disk_size()
+    {
+        return _disk.size();
+    }
+
+    // Return: number of gets served from disk.
+    size_t disk_hits() const
+    {
+        return _disk_hits.load(std::memory_order_relaxed);
+    }
+
+    // Return: stats of the memory tier; see cache.
+    cache_stats stats()
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _memory.stats();
+    }
+
+    // compact the disk tier now.
+    void compact()
+    {
+        _disk.compact();
+    }
+
+    bool check_consistency(std::string & details)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _memory.check_consistency(details);
+    }
+
+    // No copy construction or assignment.
+    tiered_cache(const tiered_cache &) = delete;
+    tiered_cache & operator=(const tiered_cache &) = delete;
+
+private:
+    std::mutex _mutex;
+    memory_type _memory;
+    disk_type _disk;
+    std::atomic<size_t> _disk_hits;
+};
+}
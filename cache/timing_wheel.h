@@ -0,0 +1,226 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A hierarchical timing wheel in C++11.
+//      Schedules expiry of small integer ids, like cache slots, in O(1) per
+//      id, and calls back each id as time advances past its expiry.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "eviction_policy.h"
+
+/*
+Notes:
+Time is counted in ticks of a fixed duration since construction.
+There are 4 wheels of 64 buckets. Wheel L holds ids expiring 64^L to
+64^(L+1) ticks from now, in the bucket of bits 6L..6L+5 of their expiry tick.
+Each tick fires the current bucket of wheel 0. When the current bucket of
+wheel 0 wraps around, the current bucket of wheel 1 is cascaded, that is its
+ids are scheduled again, now landing in wheel 0; and so on up the wheels.
+So schedule, cancel and firing are O(1) per id, and an id is cascaded at
+most 3 times.
+Ids expiring beyond 64^4 ticks are parked in the farthest bucket of wheel 3
+and scheduled again when it is cascaded.
+The buckets are lists of ids linked through an array sized to capacity at
+construction, so nothing is allocated afterwards.
+An id fires at the first tick boundary at or after its expiry, never early.
+advance skips the ticks at which no bucket fires and no bucket that is not
+empty cascades, found by looking at most 64 buckets ahead in each wheel. So
+after a long idle gap with far expiries pending, it costs O(1) per bucket
+that fires or cascades, not a step per elapsed tick.
+*/
+namespace utils
+{
+
+class timing_wheel
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    // Params:
+    //        capacity: ids are in [0, capacity).
+    //        tick: resolution of expiry times.
+    //        now: time of tick 0.
+    timing_wheel(
+        size_t capacity, clock::duration tick, clock::time_point now = clock::now()
+    ) :
+        _tick(tick),
+        _origin(now),
+        _now_tick(0),
+        _lists(capacity),
+        _buckets(levels * wheel_size),
+        _expiry(capacity, 0),
+        _bucket_of(capacity, uint32_t(npos)),
+        _count(0)
+    {
+    }
+
+    // (re)schedule id to fire at expires.
+    void schedule(uint32_t id, clock::time_point expires)
+    {
+        cancel(id);
+        auto t = tick_of(expires);
+        _expiry[id] = (t > _now_tick) ? t : _now_tick + 1;
+        place(id);
+        ++_count;
+    }
+
+    // unschedule id, if scheduled.
+    void cancel(uint32_t id)
+    {
+        auto b = _bucket_of[id];
+        if (b != npos)
+        {
+            _lists.remove(_buckets[b], id);
+            _bucket_of[id] = npos;
+            --_count;
+        }
+    }
+
+    inline bool scheduled(uint32_t id) const
+    {
+        return _bucket_of[id] != npos;
+    }
+
+    // number of ids scheduled.
+    inline size_t size() const
+    {
+        return _count;
+    }
+
+    // advance time to now, calling expired(id) for each id that expires.
+    // expired may schedule and cancel ids.
+    template<typename FN>
+    void advance(clock::time_point now, FN && expired)
+    {
+        auto target = (now > _origin) ? uint64_t((now - _origin) / _tick) : 0;
+        while (_now_tick < target)
+        {
+            if (_count == 0)
+            {
+                _now_tick = target;
+                break;
+            }
+            _now_tick = next_event(target);
+            for (size_t level = levels - 1; level > 0; --level)
+            {
+                if ((_now_tick & ((uint64_t(1) << (level * bits)) - 1)) == 0)
+                {
+                    cascade(level * wheel_size + ((_now_tick >> (level * bits)) & mask));
+                }
+            }
+            auto & b = _buckets[_now_tick & mask];
+            while (b._head != npos)
+            {
+                auto id = b._head;
+                _lists.remove(b, id);
+                _bucket_of[id] = npos;
+                --_count;
+                expired(id);
+            }
+        }
+    }
+
+private:
+    static const uint32_t npos = detail::slot_lists::npos;
+    static const size_t bits = 6;
+    static const size_t wheel_size = size_t(1) << bits;
+    static const uint64_t mask = wheel_size - 1;
+    static const size_t levels = 4;
+
+    // Return: the first tick after _now_tick, and at most limit, at which a
+    //         bucket fires or a bucket that is not empty cascades; limit if
+    //         there is none.
+    uint64_t next_event(uint64_t limit) const
+    {
+        auto next = limit;
+        // wheel 0 holds expiries at most wheel_size ticks ahead.
+        for (auto t = _now_tick + 1; t < next && t <= _now_tick + wheel_size; ++t)
+        {
+            if (_buckets[t & mask]._head != npos)
+            {
+                next = t;
+                break;
+            }
+        }
+        for (size_t level = 1; level < levels; ++level)
+        {
+            auto span = uint64_t(1) << (level * bits);
+            // in wheel_size boundaries every bucket of the wheel cascades.
+            auto t = (_now_tick / span + 1) * span;
+            for (size_t k = 0; k < wheel_size && t < next; ++k, t += span)
+            {
+                if (_buckets[level * wheel_size + ((t >> (level * bits)) & mask)]._head != npos)
+                {
+                    next = t;
+                    break;
+                }
+            }
+        }
+        return next;
+    }
+
+    // first tick at or after t.
+    uint64_t tick_of(clock::time_point t) const
+    {
+        if (t <= _origin)
+        {
+            return 0;
+        }
+        auto d = t - _origin;
+        auto ticks = uint64_t(d / _tick);
+        return (d % _tick != clock::duration::zero()) ? ticks + 1 : ticks;
+    }
+
+    // put id in the bucket for its expiry; the expiry is not in the past.
+    void place(uint32_t id)
+    {
+        auto t = _expiry[id];
+        auto delta = t - _now_tick;
+        size_t level = 0;
+        while (level + 1 < levels && delta >= (uint64_t(1) << ((level + 1) * bits)))
+        {
+            ++level;
+        }
+        auto index = (delta >> (levels * bits))
+            // beyond the top wheel; park in its farthest bucket.
+            ? ((_now_tick >> (level * bits)) + mask) & mask
+            : (t >> (level * bits)) & mask;
+        auto b = uint32_t(level * wheel_size + index);
+        _lists.push_back(_buckets[b], id);
+        _bucket_of[id] = b;
+    }
+
+    void cascade(size_t b)
+    {
+        // detach the bucket first, since ids may land in it again.
+        auto ids = _buckets[b];
+        _buckets[b] = detail::slot_lists::list{};
+        while (ids._head != npos)
+        {
+            auto id = ids._head;
+            _lists.remove(ids, id);
+            place(id);
+        }
+    }
+
+    clock::duration _tick;
+    clock::time_point _origin;
+    uint64_t _now_tick;
+    detail::slot_lists _lists;
+    std::vector<detail::slot_lists::list> _buckets;
+    // expiry tick of each id.
+    std::vector<uint64_t> _expiry;
+    std::vector<uint32_t> _bucket_of;
+    size_t _count;
+};
+}
@@ -0,0 +1,304 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      W-TinyLFU eviction and admission policy for cache in C++11.
+//      New items enter a small lru window. An item leaving the window is
+//      admitted to the main region only if it has been seen more often than
+//      the item it would replace, so scans of one-off keys do not flush the
+//      frequently used items.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "eviction_policy.h"
+
+/*
+Notes:
+frequency_sketch:
+    a count-min sketch of 4 rows of 4 bit counters, 16 counters to a 64 bit
+    word, with as many counters per row as the capacity rounded up to a power
+    of 2. The frequency of a hash is the smallest of its 4 counters, so it
+    can only be overestimated, by collisions.
+    In front of it is a doorkeeper, a bloom filter that takes the first
+    sighting of a hash. Only later sightings reach the counters, so the many
+    keys seen once do not crowd the counters.
+    Aging: after 10 increments per counter of a row, all counters are halved
+    and the doorkeeper is cleared. So old popularity fades and the sketch
+    follows changes in the workload.
+
+tinylfu_policy:
+    slots are in one of three lru lists,
+    window      about 1% of capacity. Every new item enters here.
+    probation   main region items that have not been hit since they entered
+                the main region.
+    protected   main region items hit at least once in the main region; at
+                most 80% of the main region. A protected item pushed out by a
+                newly protected one goes back to probation.
+    When the cache is full and the window is full, the lru item of the window
+    is the candidate and the lru item of probation (or protected, if
+    probation is empty) is the victim. Whichever has the lower frequency in
+    the sketch is ejected; on a tie the victim stays, since an attacker or a
+    scan can easily tie but rarely beat a popular item. A winning candidate
+    moves to probation.
+    Every hit and every new item counts as a sighting of the key in the
+    sketch. A miss does not, so a get that misses followed by a put counts
+    once, and a key seen once stays in the doorkeeper.
+    The window keeps recency: an item that is used in a burst gets a chance
+    to build up frequency before it has to compete.
+*/
+namespace utils
+{
+
+class frequency_sketch
+{
+public:
+    explicit frequency_sketch(size_t capacity) : _additions(0)
+    {
+        size_t width = 16;
+        while (width < capacity)
+        {
+            width *= 2;
+        }
+        _width_bits = 0;
+        while ((size_t(1) << _width_bits) < width)
+        {
+            ++_width_bits;
+        }
+        _table.assign(rows * width / counters_per_word, 0);
+        _doorkeeper.assign(std::max(width * 4 / 64, size_t(1)), 0);
+        _doorkeeper_mask = _doorkeeper.size() * 64 - 1;
+        _sample_size = 10 * width;
+    }
+
+    // record a sighting of hash.
+    void increment(uint64_t hash)
+    {
+        if (doorkeeper_insert(hash))
+        {
+            for (size_t r=0; r<rows; ++r)
+            {
+                auto i = index(hash, r);
+                auto shift = (i % counters_per_word) * 4;
+                auto & word = _table[i / counters_per_word];
+                if (((word >> shift) & 0xF) != 0xF)
+                {
+                    word += uint64_t(1) << shift;
+                }
+            }
+        }
+        if (++_additions >= _sample_size)
+        {
+            age();
+        }
+    }
+
+    // Return: estimated number of sightings of hash since it last aged.
+    // At most 16.
+    unsigned frequency(uint64_t hash) const
+    {
+        unsigned f = 0xF;
+        for (size_t r=0; r<rows; ++r)
+        {
+            auto i = index(hash, r);
+            auto shift = (i % counters_per_word) * 4;
+            f = std::min(f, unsigned(_table[i / counters_per_word] >> shift) & 0xF);
+        }
+        return f + (doorkeeper_contains(hash) ? 1 : 0);
+    }
+
+    // halve all counters and clear the doorkeeper.
+    void age()
+    {
+        for (auto & word : _table)
+        {
+            word = (word >> 1) & 0x7777777777777777ull;
+        }
+        std::fill(_doorkeeper.begin(), _doorkeeper.end(), 0);
+        _additions /= 2;
+    }
+
+private:
+    static const size_t rows = 4;
+    static const size_t counters_per_word = 16;
+
+    // counter index of hash in row r, in the whole table.
+    size_t index(uint64_t hash, size_t r) const
+    {
+        // a different odd multiplier per row; the high bits are well mixed.
+        static const uint64_t seeds[rows] = {
+            0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full,
+            0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull
+        };
+        auto h = (hash ^ (hash >> 32)) * seeds[r];
+        return (r << _width_bits) + size_t(h >> (64 - _width_bits));
+    }
+
+    // Return: true if hash may have been in the doorkeeper already.
+    bool doorkeeper_insert(uint64_t hash)
+    {
+        auto b1 = hash & _doorkeeper_mask;
+        auto b2 = (hash >> 32) & _doorkeeper_mask;
+        auto & w1 = _doorkeeper[b1 / 64];
+        auto & w2 = _doorkeeper[b2 / 64];
+        bool present = (w1 >> (b1 % 64) & 1) && (w2 >> (b2 % 64) & 1);
+        w1 |= uint64_t(1) << (b1 % 64);
+        w2 |= uint64_t(1) << (b2 % 64);
+        return present;
+    }
+
+    bool doorkeeper_contains(uint64_t hash) const
+    {
+        auto b1 = hash & _doorkeeper_mask;
+        auto b2 = (hash >> 32) & _doorkeeper_mask;
+        return (_doorkeeper[b1 / 64] >> (b1 % 64) & 1)
+            && (_doorkeeper[b2 / 64] >> (b2 % 64) & 1);
+    }
+
+    size_t _width_bits;
+    std::vector<uint64_t> _table;
+    std::vector<uint64_t> _doorkeeper;
+    uint64_t _doorkeeper_mask;
+    size_t _additions;
+    // age when _additions reaches this.
+    size_t _sample_size;
+};
+
+class tinylfu_policy
+{
+public:
+    static const bool concurrent_hits = false;
+
+    explicit tinylfu_policy(size_t capacity) :
+        _lists(capacity),
+        _segment(capacity, window),
+        _hashes(capacity, 0),
+        _sketch(capacity),
+        _window_capacity(std::max(capacity / 100, size_t(1))),
+        _protected_capacity(
+            (capacity - std::min(capacity, _window_capacity)) * 4 / 5
+        )
+    {
+    }
+
+    void on_insert(uint32_t slot, uint64_t hash)
+    {
+        _hashes[slot] = hash;
+        _sketch.increment(hash);
+        _segment[slot] = window;
+        _lists.push_back(_window, slot);
+        // only while the cache fills up; victim makes room otherwise.
+        if (_window._size > _window_capacity)
+        {
+            move(_window._head, _window, _probation, probation);
+        }
+    }
+
+    void on_hit(uint32_t slot)
+    {
+        _sketch.increment(_hashes[slot]);
+        switch (_segment[slot])
+        {
+        case window:
+            _lists.move_to_back(_window, slot);
+            break;
+        case probation:
+            move(slot, _probation, _protected, protected_);
+            if (_protected._size > _protected_capacity)
+            {
+                move(_protected._head, _protected, _probation, probation);
+            }
+            break;
+        default:
+            _lists.move_to_back(_protected, slot);
+            break;
+        }
+    }
+
+    // a miss is counted by the insert that usually follows it.
+    void on_miss(uint64_t) const
+    {
+    }
+
+    void on_erase(uint32_t slot)
+    {
+        _lists.remove(list_of(_segment[slot]), slot);
+    }
+
+    uint32_t victim(uint64_t)
+    {
+        auto main_size = _probation._size + _protected._size;
+        if (_window._size < _window_capacity && main_size)
+        {
+            return main_victim();
+        }
+        auto candidate = _window._head;
+        if (main_size == 0)
+        {
+            return candidate;
+        }
+        auto v = main_victim();
+        if (_sketch.frequency(_hashes[candidate]) > _sketch.frequency(_hashes[v]))
+        {
+            move(candidate, _window, _probation, probation);
+            return v;
+        }
+        return candidate;
+    }
+
+    template<typename FN>
+    void for_each(FN fn) const
+    {
+        _lists.for_each(_window, fn);
+        _lists.for_each(_probation, fn);
+        _lists.for_each(_protected, fn);
+    }
+
+    const frequency_sketch & sketch() const
+    {
+        return _sketch;
+    }
+
+private:
+    enum segment : uint8_t { window, probation, protected_ };
+
+    uint32_t main_victim() const
+    {
+        return _probation._size ? _probation._head : _protected._head;
+    }
+
+    detail::slot_lists::list & list_of(uint8_t seg)
+    {
+        return seg == window ? _window : seg == probation ? _probation : _protected;
+    }
+
+    void move(
+        uint32_t slot,
+        detail::slot_lists::list & from, detail::slot_lists::list & to,
+        segment seg
+    )
+    {
+        _lists.remove(from, slot);
+        _lists.push_back(to, slot);
+        _segment[slot] = seg;
+    }
+
+    detail::slot_lists _lists;
+    detail::slot_lists::list _window;
+    detail::slot_lists::list _probation;
+    detail::slot_lists::list _protected;
+    std::vector<uint8_t> _segment;
+    // key hash of each slot, to look up the sketch on hits.
+    std::vector<uint64_t> _hashes;
+    frequency_sketch _sketch;
+    size_t _window_capacity;
+    size_t _protected_capacity;
+};
+}
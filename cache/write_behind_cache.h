@@ -0,0 +1,343 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A write behind cache in C++11 on top of cache.
+//      put only marks the item dirty. A background thread writes the dirty
+//      items to the backing store in batches, so many small writes become
+//      a few large ones.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cache.h"
+
+/*
+Notes:
+1.  The writer is given a batch of {key, value} to write to the backing
+    store. A key is in a batch at most once, with its latest value, however
+    many times it was put since the last write.
+2.  A batch is written
+        - every interval, by the background thread,
+        - when batch_size dirty items have left the cache, since then they
+          are held outside it,
+        - when flush() is called, and at destruction.
+    A dirty item that leaves the cache, evicted, expired or erased, is kept
+    through the removal listener of cache until it is written, and get
+    still finds it there, so a put is read back until the backing store has
+    it. An erase is of the cached item only; its pending write still
+    happens. An item the cache rejects, say with capacity 0, is kept the
+    same way.
+3.  Batches are written one at a time, in the order they are taken, outside
+    the lock, so gets and puts do not wait on the backing store.
+4.  If the writer throws, the items of the batch are dirty again, unless
+    put again meanwhile, and are retried with the next batch. flush()
+    rethrows the exception; the background thread counts it in
+    write_failures().
+5.  All operations take one mutex; the cache is meant to front a slow store,
+    not to scale across many threads.
+*/
+namespace utils
+{
+
+template<
+    typename KEY, typename VAL,
+    typename POLICY = lru_policy, typename HASH = std::hash<KEY>,
+    typename KEYEQ = std::equal_to<KEY>
+>
+class write_behind_cache
+{
+    // the cached value and whether it is yet to be written.
+    struct item
+    {
+        VAL _val;
+        mutable bool _dirty;
+    };
+
+    using cache_type = cache<KEY, item, POLICY, flat_index, HASH, KEYEQ>;
+
+public:
+    using clock = typename cache_type::clock;
+    using batch_type = std::vector<std::pair<KEY, VAL>>;
+    using writer_type = std::function<void(const batch_type &)>;
+
+    // Params:
+    //        capacity: maximum number of items cached.
+    //        writer: writes a batch to the backing store; may throw.
+    //        interval: time between background writes.
+    //        batch_size: number of dirty items out of the cache that
+    //                    triggers a background write.
+    write_behind_cache(
+        size_t capacity, writer_type writer,
+        typename clock::duration interval, size_t batch_size = 256
+    ) :
+        _cache(capacity),
+        _writer(std::move(writer)),
+        _interval(interval),
+        _batch_size(std::max(batch_size, size_t{1})),
+        _write_failures(0),
+        _dirty_cached(0),
+        _stop(false)
+    {
+        _cache.set_removal_listener(
+            [this](const KEY & key, const item & it, removal_cause){
+                if (it._dirty)
+                {
+                    _removed[key] = it._val;
+                    --_dirty_cached;
+                }
+            }
+        );
+        _worker = std::thread(&write_behind_cache::worker, this);
+    }
+
+    // write the remaining dirty items; an exception from the writer is
+    // ignored here, call flush() first to see it.
+    ~write_behind_cache()
+    {
+        {
+            std::lock_guard<std::mutex> l{_mutex};
+            _stop = true;
+        }
+        _wake.notify_all();
+        _worker.join();
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    // if found in cache, or waiting to be written, copies to val and
+    // return true.
+    bool get(const KEY & key, VAL & val)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        auto p = _cache.get(key);
+        if (p)
+        {
+            val = p->_val;
+            return true;
+        }
+        auto itr = _removed.find(key);
+        if (itr == _removed.end())
+        {
+            return false;
+        }
+        val = itr->second;
+        return true;
+    }
+
+    // put the item in the cache, to be written behind.
+    void put(const KEY & key, const VAL & val)
+    {
+        {
+            std::lock_guard<std::mutex> l{_mutex};
+            auto p = _cache.peek(key);
+            bool was_dirty = p && p->_dirty;
+            // this value supersedes one waiting outside the cache.
+            _removed.erase(key);
+            if (!_cache.put(key, item{val, true}))
+            {
+                // rejected by the cache; wait outside it, like an evicted item.
+                _removed[key] = val;
+            }
+            else if (!was_dirty)
+            {
+                _dirty.push_back(key);
+                ++_dirty_cached;
+            }
+            if (_removed.size() < _batch_size)
+            {
+                return;
+            }
+        }
+        _wake.notify_one();
+    }
+
+    // Return: true if key was in the cache. A pending write of it is kept.
+    bool erase(const KEY & key)
+    {
+        bool ret;
+        {
+            std::lock_guard<std::mutex> l{_mutex};
+            ret = _cache.erase(key);
+            if (_removed.size() < _batch_size)
+            {
+                return ret;
+            }
+        }
+        _wake.notify_one();
+        return ret;
+    }
+
+    // write all dirty items now. Rethrows an exception from the writer.
+    void flush()
+    {
+        std::lock_guard<std::mutex> f{_flush_mutex};
+        batch_type batch;
+        {
+            std::lock_guard<std::mutex> l{_mutex};
+            take_dirty(batch);
+        }
+        if (batch.empty())
+        {
+            return;
+        }
+        try
+        {
+            _writer(batch);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> l{_mutex};
+            restore_dirty(batch);
+            throw;
+        }
+    }
+
+    // Return: number of items waiting to be written.
+    size_t dirty()
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _removed.size() + _dirty_cached;
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _cache.size();
+    }
+
+    // Return: number of background writes that threw.
+    size_t write_failures()
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _write_failures;
+    }
+
+    bool check_consistency(std::string & details)
+    {
+        std::lock_guard<std::mutex> l{_mutex};
+        return _cache.check_consistency(details);
+    }
+
+    // No copy construction or assignment.
+    write_behind_cache(const write_behind_cache &) = delete;
+    write_behind_cache & operator=(const write_behind_cache &) = delete;
+
+private:
+    void worker()
+    {
+        std::unique_lock<std::mutex> l{_mutex};
+        bool failed = false;
+        while (!_stop)
+        {
+            // after a failure, wait out the interval before retrying.
+            _wake.wait_for(l, _interval, [this, failed](){
+                return _stop || (!failed && _removed.size() >= _batch_size);
+            });
+            if (_stop)
+            {
+                break;
+            }
+            l.unlock();
+            try
+            {
+                flush();
+                failed = false;
+            }
+            catch (...)
+            {
+                failed = true;
+            }
+            l.lock();
+            _write_failures += failed;
+        }
+    }
+
+    // move the dirty items to batch and mark them clean. Under _mutex.
+    void take_dirty(batch_type & batch)
+    {
+        batch.reserve(_removed.size() + _dirty.size());
+        for (auto & r : _removed)
+        {
+            batch.emplace_back(r.first, std::move(r.second));
+        }
+        _removed.clear();
+        // a key is listed once per time it turned dirty in the cache.
+        for (const auto & key : _dirty)
+        {
+            auto p = _cache.peek(key);
+            if (p && p->_dirty)
+            {
+                batch.emplace_back(key, p->_val);
+                p->_dirty = false;
+            }
+        }
+        _dirty.clear();
+        _dirty_cached = 0;
+    }
+
+    // mark the items of a failed batch dirty again, unless put since.
+    // Under _mutex.
+    void restore_dirty(const batch_type & batch)
+    {
+        for (const auto & kv : batch)
+        {
+            auto p = _cache.peek(kv.first);
+            if (p)
+            {
+                // a clean item was taken by this batch, so holds its value.
+                if (!p->_dirty)
+                {
+                    p->_dirty = true;
+                    _dirty.push_back(kv.first);
+                    ++_dirty_cached;
+                }
+            }
+            else
+            {
+                // keeps a newer value that left the cache since.
+                _removed.emplace(kv.first, kv.second);
+            }
+        }
+    }
+
+    cache_type _cache;
+    writer_type _writer;
+    typename clock::duration _interval;
+    size_t _batch_size;
+    size_t _write_failures;
+
+    std::mutex _mutex;
+    // dirty items that left the cache.
+    std::unordered_map<KEY, VAL, HASH, KEYEQ> _removed;
+    // keys that turned dirty in the cache since the last batch.
+    std::vector<KEY> _dirty;
+    // number of dirty items in the cache.
+    size_t _dirty_cached;
+
+    // one batch written at a time, in order.
+    std::mutex _flush_mutex;
+    std::condition_variable _wake;
+    bool _stop;
+    std::thread _worker;
+};
+}
@@ -0,0 +1,155 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A strand (serial executor) on top of thread_pool in C++11.
+//      Tasks posted to a strand run one at a time in the order posted,
+//      while tasks of different strands run in parallel on the pool.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <future>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+
+#include "thread_pool.h"
+
+namespace utils
+{
+
+/*
+Notes:
+1.  At most one task of a strand is scheduled on the pool at any time.
+    So no worker ever blocks waiting for another task of the same strand,
+    unlike giving each session its own mutex.
+2.  When a strand is scheduled it runs up to batch_size of its queued tasks
+    before giving the worker back to the pool. This amortizes the cost of
+    scheduling without starving other strands.
+3.  The strand may be destroyed while it still has queued tasks. They will
+    still run, since the scheduled task keeps the strand state alive.
+4.  The pool must outlive all strands bound to it.
+*/
+
+class strand
+{
+public:
+    static const size_t batch_size = 16;
+
+    //
+    // pool : the thread_pool on which tasks of this strand are run.
+    //
+    explicit strand (thread_pool & pool) :
+        state_{std::make_shared<state>(pool)}
+    {
+    }
+
+    template <class Fn, class... Args>
+    std::future<typename std::result_of<Fn(Args...)>::type>
+    async (Fn&& fn, Args&&... args)
+    {
+        auto ptask = std::make_shared<
+            std::packaged_task<typename std::result_of<Fn(Args...)>::type()>
+        >(std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...));
+        state_->push([ptask](){ (*ptask)(); });
+        return ptask->get_future();
+    }
+
+    //
+    // Fire and forget version of async.
+    //
+    template <class Fn, class... Args>
+    void post (Fn&& fn, Args&&... args)
+    {
+        state_->push(
+            std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...)
+        );
+    }
+
+    // No copy construction or assignment.
+    strand(const strand &) = delete;
+    strand & operator=(const strand &) = delete;
+
+private:    // private types
+
+    struct state : public std::enable_shared_from_this<state>
+    {
+        explicit state(thread_pool & pool) : pool_(pool), scheduled_{false}
+        {
+        }
+
+        void push(std::function<void()> && fn)
+        {
+            bool schedule = false;
+            {
+                std::unique_lock<std::mutex> l{mutex_};
+                q_.push(std::move(fn));
+                if (!scheduled_)
+                {
+                    scheduled_ = schedule = true;
+                }
+            }
+            if (schedule)
+            {
+                auto self = shared_from_this();
+                pool_.post([self](){ self->run(); });
+            }
+        }
+
+        void run()
+        {
+            for (size_t i=0; i<batch_size; ++i)
+            {
+                std::function<void()> fn;
+                {
+                    std::unique_lock<std::mutex> l{mutex_};
+                    if (q_.empty())
+                    {
+                        scheduled_ = false;
+                        return;
+                    }
+                    fn = std::move(q_.front());
+                    q_.pop();
+                }
+                try
+                {
+                    fn();
+                }
+                catch(...)
+                {
+                    // must not escape, otherwise the strand stays scheduled.
+                    std::cout   << "\n Exception in strand task "
+                                << fn.target_type().name() << "\n";
+                }
+            }
+
+            // batch done; yield the worker and continue later if more queued.
+            std::unique_lock<std::mutex> l{mutex_};
+            if (q_.empty())
+            {
+                scheduled_ = false;
+            }
+            else
+            {
+                l.unlock();
+                auto self = shared_from_this();
+                pool_.post([self](){ self->run(); });
+            }
+        }
+
+        thread_pool & pool_;
+        std::mutex mutex_;
+        std::queue<std::function<void()>> q_;
+        bool scheduled_;
+    };
+
+private:    // private data members
+
+    std::shared_ptr<state> state_;
+};
+
+} // namespace utils
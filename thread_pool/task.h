@@ -0,0 +1,323 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A coroutine task type in C++20 to use with thread_pool::schedule().
+//      Allows writing asynchronous code as coroutines that run on the pool
+//      without blocking any thread.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <variant>
+
+#include "thread_pool.h"
+
+namespace utils
+{
+
+/*
+Notes:
+1.  Needs C++20. Use -std=c++20 with gcc and clang.
+2.  task<T> is lazy. Its body does not start until it is co_awaited.
+    A typical body starts with co_await pool.schedule() to move to the pool.
+3.  When a task completes, the coroutine awaiting it is resumed right away
+    on the same thread by symmetric transfer. So if the task ran on the pool,
+    the awaiting coroutine continues on the pool too.
+4.  spawn() starts a task without waiting for it. sync_wait() blocks the
+    calling thread until a task completes, and is meant for main() or tests,
+    never for a pool worker.
+5.  An exception thrown in the task body is rethrown at the co_await.
+*/
+
+template <typename T = void>
+class task;
+
+namespace detail
+{
+
+//
+// Parts of the promise common to task<T> and task<void>.
+//
+class task_promise_base
+{
+public:
+    struct final_awaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<Promise> h) noexcept
+        {
+            auto continuation = h.promise().continuation_;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    final_awaiter final_suspend() noexcept { return {}; }
+
+    void set_continuation(std::coroutine_handle<> continuation)
+    {
+        continuation_ = continuation;
+    }
+
+private:
+    // the coroutine awaiting this task.
+    std::coroutine_handle<> continuation_;
+};
+
+template <typename T>
+class task_promise : public task_promise_base
+{
+public:
+    task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U && value)
+    {
+        result_.template emplace<1>(std::forward<U>(value));
+    }
+
+    void unhandled_exception() noexcept
+    {
+        result_.template emplace<2>(std::current_exception());
+    }
+
+    T result()
+    {
+        if (result_.index() == 2)
+        {
+            std::rethrow_exception(std::get<2>(result_));
+        }
+        return std::move(std::get<1>(result_));
+    }
+
+private:
+    std::variant<std::monostate, T, std::exception_ptr> result_;
+};
+
+template <>
+class task_promise<void> : public task_promise_base
+{
+public:
+    task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void unhandled_exception() noexcept
+    {
+        error_ = std::current_exception();
+    }
+
+    void result()
+    {
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+    }
+
+private:
+    std::exception_ptr error_;
+};
+
+} // namespace detail
+
+template <typename T>
+class task
+{
+public:
+    using promise_type = detail::task_promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit task(handle_type h) noexcept : h_(h)
+    {
+    }
+
+    task(task && other) noexcept : h_(std::exchange(other.h_, {}))
+    {
+    }
+
+    task & operator=(task && other) noexcept
+    {
+        if (this != &other)
+        {
+            if (h_)
+            {
+                h_.destroy();
+            }
+            h_ = std::exchange(other.h_, {});
+        }
+        return *this;
+    }
+
+    ~task()
+    {
+        if (h_)
+        {
+            h_.destroy();
+        }
+    }
+
+    // No copy construction or assignment.
+    task(const task &) = delete;
+    task & operator=(const task &) = delete;
+
+    //
+    // Awaiting starts the task, and resumes the awaiting coroutine when the
+    // task completes.
+    //
+    auto operator co_await() && noexcept
+    {
+        struct awaiter
+        {
+            handle_type h_;
+
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                h_.promise().set_continuation(awaiting);
+                return h_;
+            }
+
+            T await_resume()
+            {
+                return h_.promise().result();
+            }
+        };
+        return awaiter{h_};
+    }
+
+    auto operator co_await() & noexcept
+    {
+        return std::move(*this).operator co_await();
+    }
+
+    //
+    // Awaiting this starts the task like co_await, but does not take the
+    // result. The result can be taken later with co_await.
+    //
+    auto when_ready() noexcept
+    {
+        struct awaiter
+        {
+            handle_type h_;
+
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                h_.promise().set_continuation(awaiting);
+                return h_;
+            }
+
+            void await_resume() const noexcept {}
+        };
+        return awaiter{h_};
+    }
+
+    //
+    // Return: the result of a completed task, or rethrows its exception.
+    //
+    T result()
+    {
+        return h_.promise().result();
+    }
+
+private:
+    handle_type h_;
+};
+
+namespace detail
+{
+
+template <typename T>
+task<T> task_promise<T>::get_return_object() noexcept
+{
+    return task<T>{
+        std::coroutine_handle<task_promise<T>>::from_promise(*this)
+    };
+}
+
+inline task<void> task_promise<void>::get_return_object() noexcept
+{
+    return task<void>{
+        std::coroutine_handle<task_promise<void>>::from_promise(*this)
+    };
+}
+
+//
+// Coroutine that is never awaited and destroys itself when done.
+//
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept
+        {
+            std::cout << "\n Exception in spawned task\n";
+        }
+    };
+};
+
+template <typename T>
+detached_task run_detached(task<T> t)
+{
+    co_await std::move(t);
+}
+
+} // namespace detail
+
+//
+// Start a task without waiting for it to complete.
+// The task frame is destroyed when the task completes.
+//
+template <typename T>
+void spawn(task<T> t)
+{
+    detail::run_detached(std::move(t));
+}
+
+//
+// Block the calling thread until the task completes.
+// Return: the result of the task, or rethrows its exception.
+//
+template <typename T>
+T sync_wait(task<T> t)
+{
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+
+    auto notify = [&]() -> task<void> {
+        co_await t.when_ready();
+        std::unique_lock<std::mutex> l{m};
+        done = true;
+        cv.notify_one();
+    };
+    spawn(notify());
+
+    std::unique_lock<std::mutex> l{m};
+    cv.wait(l, [&done](){ return done; });
+    return t.result();
+}
+
+} // namespace utils
@@ -0,0 +1,193 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      A fork-join task group on top of thread_pool in C++11.
+//      Allows recursive divide and conquer algorithms to spawn child tasks
+//      with run() and join them with wait().
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "thread_pool.h"
+
+namespace utils
+{
+
+/*
+Notes:
+1.  Unlike thread_pool::async, run() does not allocate a promise per task.
+    Completion is tracked by a single counter in the group.
+2.  Children wait in a queue local to the group, and for each one a ticket
+    is posted to the pool. A worker running a ticket takes the oldest child
+    of the group, if any is left. wait() takes the newest children of its
+    own group and runs them on the calling thread, and only blocks when the
+    rest are already running elsewhere.
+    So a pool worker can wait on its children without deadlocking the pool,
+    even when every worker is inside a wait(): a child is either still
+    queued, and run by its waiter, or running on some thread.
+3.  wait() never runs tasks of other groups or of the pool, so the calling
+    thread nests one frame per level of recursion, as the same algorithm
+    run serially would, however many tasks are spawned in total.
+    Workers take the oldest children, which in divide and conquer are the
+    largest pieces, as in work stealing.
+4.  The first exception thrown by a child is rethrown by wait().
+5.  wait() must be called before the group is destroyed. The destructor
+    waits as a safeguard but discards any exception. The queue is shared
+    with the tickets, so a ticket that runs after the group is gone finds
+    nothing to do.
+*/
+
+class task_group
+{
+public:
+    //
+    // pool : the thread_pool on which child tasks are run.
+    //
+    explicit task_group (thread_pool & pool) :
+        pool_(pool), state_(std::make_shared<state>())
+    {
+    }
+
+    template <class Fn, class... Args>
+    void run (Fn&& fn, Args&&... args)
+    {
+        {
+            std::unique_lock<std::mutex> l{state_->mutex_};
+            ++state_->pending_;
+            state_->children_.emplace_back(
+                std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...)
+            );
+            if (state_->waiting_)
+            {
+                state_->cv_.notify_all();
+            }
+        }
+        auto s = state_;
+        pool_.post(
+            [s]() {
+                std::unique_lock<std::mutex> l{s->mutex_};
+                if (s->children_.empty())
+                {
+                    // already run by wait().
+                    return;
+                }
+                auto child = std::move(s->children_.front());
+                s->children_.pop_front();
+                l.unlock();
+                s->run_child(child);
+            }
+        );
+    }
+
+    void wait()
+    {
+        auto & s = *state_;
+        std::unique_lock<std::mutex> l{s.mutex_};
+        for (;;)
+        {
+            if (!s.children_.empty())
+            {
+                auto child = std::move(s.children_.back());
+                s.children_.pop_back();
+                l.unlock();
+                s.run_child(child);
+                l.lock();
+                continue;
+            }
+            if (s.pending_ == 0)
+            {
+                break;
+            }
+            // the rest are running elsewhere.
+            s.waiting_ = true;
+            s.cv_.wait(l);
+            s.waiting_ = false;
+        }
+
+        std::exception_ptr error;
+        std::swap(error, s.error_);
+        l.unlock();
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    ~task_group()
+    {
+        try
+        {
+            wait();
+        }
+        catch(...)
+        {
+        }
+    }
+
+    // No copy construction or assignment.
+    task_group(const task_group &) = delete;
+    task_group & operator=(const task_group &) = delete;
+
+private:    // private types
+
+    // shared by the group and its tickets in the pool.
+    struct state
+    {
+        state() : pending_(0), waiting_(false)
+        {
+        }
+
+        void run_child(std::function<void()> & child)
+        {
+            try
+            {
+                child();
+            }
+            catch(...)
+            {
+                std::unique_lock<std::mutex> l{mutex_};
+                if (!error_)
+                {
+                    error_ = std::current_exception();
+                }
+            }
+            std::unique_lock<std::mutex> l{mutex_};
+            if (--pending_ == 0)
+            {
+                cv_.notify_all();
+            }
+        }
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+
+        // children not yet started; newest at the back.
+        std::deque<std::function<void()>> children_;
+
+        // number of children spawned and not yet finished.
+        size_t pending_;
+
+        // wait() is blocked on cv_.
+        bool waiting_;
+
+        // first exception thrown by a child.
+        std::exception_ptr error_;
+    };
+
+private:    // private data members
+
+    thread_pool & pool_;
+    std::shared_ptr<state> state_;
+};
+
+} // namespace utils
@@ -0,0 +1,96 @@
+#include "strand.h"
+#include "../test/test.h"
+
+#include <atomic>
+#include <vector>
+
+using namespace utils;
+
+void test_interface_basic()
+{
+    thread_pool tp(2);
+    strand s(tp);
+
+    auto f = s.async([](int a, int b){ return a + b; }, 3, 4);
+    ASSERT_M(f.get() == 7, "strand async non-void return");
+
+    std::atomic<bool> ran{false};
+    s.async([&ran](){ ran = true; }).get();
+    ASSERT_M(ran, "strand async void return");
+
+    auto fe = s.async([]()->int{ throw std::runtime_error("oops"); });
+    bool caught = false;
+    try
+    {
+        fe.get();
+    }
+    catch(std::runtime_error &)
+    {
+        caught = true;
+    }
+    ASSERT_M(caught, "strand async exception propagated to future");
+}
+
+void test_order()
+{
+    thread_pool tp(4);
+    strand s(tp);
+
+    // no lock on order: the strand must serialize the tasks.
+    std::vector<int> order;
+    for (int i=0; i<1000; ++i)
+    {
+        s.post([&order, i](){ order.push_back(i); });
+    }
+    s.async([](){}).get();
+
+    bool inorder = (order.size() == 1000);
+    for (size_t i=0; inorder && i<order.size(); ++i)
+    {
+        inorder = (order[i] == int(i));
+    }
+    ASSERT_M(inorder, "strand tasks run in the order posted");
+}
+
+void test_serial_and_parallel()
+{
+    thread_pool tp(4);
+    strand s1(tp);
+    strand s2(tp);
+
+    std::atomic<int> running1{0};
+    std::atomic<bool> overlap{false};
+    std::atomic<bool> s2ran{false};
+    std::atomic<bool> wait{true};
+
+    // s1 blocks its task until s2 has run, which needs parallel strands.
+    s1.post([&](){
+        if (++running1 > 1) overlap = true;
+        while (wait);
+        --running1;
+    });
+    for (int i=0; i<100; ++i)
+    {
+        s1.post([&](){
+            if (++running1 > 1) overlap = true;
+            --running1;
+        });
+    }
+    s2.async([&](){ s2ran = true; }).get();
+    wait = false;
+    s1.async([](){}).get();
+
+    ASSERT_M(s2ran, "different strands run in parallel");
+    ASSERT_M(!overlap, "tasks of one strand never overlap");
+}
+
+int main()
+{
+    test_interface_basic();
+    test_order();
+    test_serial_and_parallel();
+
+    std::cout << "\n done";
+    //getchar();
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Needs C++20. For example g++ -std=c++20 -pthread test_task.cpp
+#include "task.h"
+#include "../test/test.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace utils;
+
+task<int> add(thread_pool & tp, int a, int b)
+{
+    co_await tp.schedule();
+    co_return a + b;
+}
+
+task<std::thread::id> worker_id(thread_pool & tp)
+{
+    co_await tp.schedule();
+    co_return std::this_thread::get_id();
+}
+
+task<int> fail(thread_pool & tp)
+{
+    co_await tp.schedule();
+    throw std::runtime_error("oops");
+}
+
+task<int> sum_nested(thread_pool & tp)
+{
+    co_await tp.schedule();
+    int a = co_await add(tp, 1, 2);
+    int b = co_await add(tp, 3, 4);
+    co_return a + b;
+}
+
+void test_interface_basic()
+{
+    thread_pool tp(2);
+    ASSERT_M(sync_wait(add(tp, 3, 4)) == 7, "task non-void return");
+
+    bool ran = false;
+    auto set = [&]() -> task<void> {
+        co_await tp.schedule();
+        ran = true;
+    };
+    sync_wait(set());
+    ASSERT_M(ran, "task void return");
+
+    ASSERT_M(
+        sync_wait(worker_id(tp)) != std::this_thread::get_id(),
+        "schedule resumes on a pool worker"
+    );
+}
+
+void test_nested()
+{
+    thread_pool tp(2);
+    ASSERT_M(sync_wait(sum_nested(tp)) == 10, "task awaiting tasks");
+}
+
+void test_exception()
+{
+    thread_pool tp(2);
+    bool caught = false;
+    try
+    {
+        sync_wait(fail(tp));
+    }
+    catch(std::runtime_error &)
+    {
+        caught = true;
+    }
+    ASSERT_M(caught, "task exception rethrown at await");
+}
+
+void test_many_in_flight()
+{
+    // far more coroutines in flight than threads in the pool.
+    thread_pool tp(2);
+    const int n = 10000;
+    std::atomic<int> count{0};
+    auto one = [&]() -> task<void> {
+        co_await tp.schedule();
+        int v = co_await add(tp, 1, 0);
+        count += v;
+    };
+    auto all = [&]() -> task<void> {
+        for (int i=0; i<n; ++i)
+        {
+            spawn(one());
+        }
+        co_return;
+    };
+    sync_wait(all());
+    while (count != n)
+    {
+        std::this_thread::yield();
+    }
+    ASSERT_M(count == n, "task many in flight with spawn");
+}
+
+int main()
+{
+    test_interface_basic();
+    test_nested();
+    test_exception();
+    test_many_in_flight();
+
+    std::cout << "\n done";
+    //getchar();
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "task_group.h"
+#include "../test/test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace utils;
+
+long fib(thread_pool & tp, int n)
+{
+    if (n < 2)
+    {
+        return n;
+    }
+    long a = 0, b = 0;
+    task_group tg(tp);
+    tg.run([&tp, &a, n](){ a = fib(tp, n - 1); });
+    b = fib(tp, n - 2);
+    tg.wait();
+    return a + b;
+}
+
+void quicksort(thread_pool & tp, int * begin, int * end)
+{
+    if (end - begin < 64)
+    {
+        std::sort(begin, end);
+        return;
+    }
+    auto pivot = *(begin + (end - begin) / 2);
+    auto mid1 = std::partition(begin, end, [pivot](int x){ return x < pivot; });
+    auto mid2 = std::partition(mid1, end, [pivot](int x){ return !(pivot < x); });
+    task_group tg(tp);
+    tg.run(quicksort, std::ref(tp), begin, mid1);
+    tg.run(quicksort, std::ref(tp), mid2, end);
+    tg.wait();
+}
+
+void test_interface_basic()
+{
+    thread_pool tp(2);
+    std::atomic<int> ai{0};
+    task_group tg(tp);
+    for (int i=0; i<100; ++i)
+    {
+        tg.run([&ai](int n){ ai += n; }, 1);
+    }
+    tg.wait();
+    ASSERT_M(ai == 100, "task_group run and wait");
+}
+
+void test_recursive()
+{
+    // fewer threads than the depth of recursion, so waiting workers
+    // must help or the pool would deadlock.
+    thread_pool tp(2);
+    ASSERT_M(fib(tp, 20) == 6765, "task_group recursive spawn and sync");
+
+    std::vector<int> v(100000);
+    std::iota(v.begin(), v.end(), 0);
+    std::reverse(v.begin(), v.end());
+    quicksort(tp, v.data(), v.data() + v.size());
+    ASSERT_M(std::is_sorted(v.begin(), v.end()), "task_group quicksort");
+}
+
+void test_deep_spawn()
+{
+    // a spawn tree of about 240K tasks; wait() must only nest as deep as
+    // the recursion, or the stack overflows.
+    thread_pool tp(2);
+    ASSERT_M(fib(tp, 25) == 75025, "task_group deep and wide spawn tree");
+
+    thread_pool one(1);
+    ASSERT_M(fib(one, 22) == 17711, "task_group spawn tree on one worker");
+}
+
+void test_exception()
+{
+    thread_pool tp(2);
+    task_group tg(tp);
+    tg.run([](){ throw std::runtime_error("oops"); });
+    tg.run([](){});
+    bool caught = false;
+    try
+    {
+        tg.wait();
+    }
+    catch(std::runtime_error &)
+    {
+        caught = true;
+    }
+    ASSERT_M(caught, "task_group wait rethrows child exception");
+}
+
+int main()
+{
+    test_interface_basic();
+    test_recursive();
+    test_deep_spawn();
+    test_exception();
+
+    std::cout << "\n done";
+    //getchar();
+    return 0;
+}
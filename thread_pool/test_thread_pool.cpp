@@ -2,6 +2,7 @@
 #include "../test/test.h"
 
 #include <string>
+#include <vector>
 
 using namespace utils;
 
@@ -136,10 +137,40 @@ void test_concurrency()
     ASSERT_M(issuccess, "thread_pool 3 threads concurrency test");
 }
 
+void test_post()
+{
+    thread_pool tp(2);
+    std::atomic<int> ai{0};
+    for (int i=0; i<100; ++i)
+    {
+        tp.post([&ai](int n){ ai += n; }, 1);
+    }
+    tp.join();
+    ASSERT_M(ai == 100, "post fire and forget");
+}
+
+void test_scratch()
+{
+    thread_pool tp(1);
+    auto first = tp.async([](){
+        std::vector<int, arena_allocator<int>> v{
+            arena_allocator<int>{thread_pool::scratch()}
+        };
+        v.push_back(1);
+        return static_cast<void *>(v.data());
+    }).get();
+    auto second = tp.async([](){
+        return thread_pool::scratch().allocate(sizeof(int), alignof(int));
+    }).get();
+    ASSERT_M(first == second, "scratch arena rewound after each task");
+}
+
 int main()
 {
     test_interface_basic();
     test_concurrency();
+    test_post();
+    test_scratch();
 
     std::cout << "\n done";
     //getchar();
@@ -0,0 +1,79 @@
+#define THREAD_POOL_METRICS
+#include "thread_pool.h"
+#include "../test/test.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace utils;
+
+void test_histogram()
+{
+    latency_histogram h;
+    ASSERT_M(h.count() == 0 && h.percentile(0.5) == 0, "empty histogram");
+    h.buckets[0] = 90;      // [0, 2) ns
+    h.buckets[10] = 10;     // [1024, 2048) ns
+    ASSERT_M(h.count() == 100, "histogram count");
+    ASSERT_M(h.percentile(0.5) == 1, "histogram p50");
+    ASSERT_M(h.percentile(0.99) == 2047, "histogram p99");
+}
+
+void test_tasks_executed()
+{
+    thread_pool tp(2);
+    for (int i=0; i<100; ++i)
+    {
+        tp.async([](){}).get();
+    }
+    tp.post([](){ std::this_thread::sleep_for(std::chrono::milliseconds(2)); });
+    tp.join();
+
+    auto m = tp.metrics();
+    ASSERT_M(m.enabled, "metrics enabled");
+    ASSERT_M(m.workers.size() == 2, "metrics per worker");
+    ASSERT_M(
+        m.total.tasks_executed >= 101
+            && m.total.run_time.count() == m.total.tasks_executed
+            && m.total.queue_wait.count() == m.total.tasks_executed,
+        "metrics tasks executed"
+    );
+    ASSERT_M(
+        m.total.run_time.percentile(1.0) >= 2000000,
+        "metrics run time histogram"
+    );
+    ASSERT_M(
+        m.total.busy_time >= std::chrono::milliseconds(2)
+            && m.total.utilization() > 0.0 && m.total.utilization() <= 1.0,
+        "metrics busy time and utilization"
+    );
+}
+
+void test_queue_wait()
+{
+    thread_pool tp(1);
+    std::atomic<bool> wait{true};
+    tp.post([&wait](){ while (wait); });
+    tp.post([](){});
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    ASSERT_M(tp.metrics().queue_size == 1, "metrics queue size");
+    wait = false;
+    tp.join();
+
+    auto m = tp.metrics();
+    ASSERT_M(
+        m.total.queue_wait.percentile(1.0) >= 2000000,
+        "metrics queue wait histogram"
+    );
+}
+
+int main()
+{
+    test_histogram();
+    test_tasks_executed();
+    test_queue_wait();
+
+    std::cout << "\n done";
+    //getchar();
+    return 0;
+}
@@ -13,12 +13,20 @@
 
 #include <future>
 #include <functional>
+#include <chrono>
 #include <memory>
 #include <iostream>
 #include <thread>
+#include <typeinfo>
 #include <vector>
 
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#endif
+
+#include "../allocator/monotonic_arena.h"
 #include "../queue_mt/queue_mt.h"
+#include "thread_pool_metrics.h"
 
 namespace utils
 {
@@ -27,6 +35,13 @@ namespace utils
 Notes:
 1.  Use -pthread option with gcc and clang.
 2.  Unlike std::async, cannot queue functions with rvalue parameters for now.
+3.  With C++20 coroutines, co_await schedule() resumes the coroutine on a
+    worker. See task.h for a coroutine type to use with it.
+4.  Define THREAD_POOL_METRICS to collect execution metrics. See
+    thread_pool_metrics.h.
+5.  scratch() gives a task the arena of the thread running it. Whatever the
+    task allocates from it is released when the task returns. A coroutine
+    must not keep scratch memory across a co_await.
 */
 
 class thread_pool
@@ -39,10 +54,14 @@ public:
         quit_{false}
     {
         num_threads = std::max(num_threads, size_t{1});
+        num_threads_ = num_threads;
+#ifdef THREAD_POOL_METRICS
+        counters_.reset(new detail::worker_counters[num_threads]);
+#endif
         threads_.reserve(num_threads);
         for(size_t i=0; i<num_threads; ++i)
         {
-            threads_.emplace_back(&thread_pool::thread_func, this);
+            threads_.emplace_back(&thread_pool::thread_func, this, i);
         }
         std::cout << "\nthread_pool: started " << num_threads << " threads.";
     }
@@ -72,6 +91,86 @@ public:
         return ppromise->get_future();
     }
 
+    //
+    // Fire and forget version of async.
+    // No promise or future is created, so this is cheaper when the caller
+    // does not need the result. Exceptions thrown by fn are caught and
+    // reported by the worker thread.
+    //
+    template <class Fn, class... Args>
+    void post (Fn&& fn, Args&&... args)
+    {
+        q_.emplace(std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...));
+    }
+
+#ifdef __cpp_impl_coroutine
+    //
+    // Awaitable returned by schedule().
+    //
+    class schedule_awaiter
+    {
+    public:
+        explicit schedule_awaiter(thread_pool & pool) : pool_(pool)
+        {
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            pool_.post([h](){ h.resume(); });
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        thread_pool & pool_;
+    };
+
+    //
+    // co_await pool.schedule() suspends the calling coroutine and resumes
+    // it on a worker of the pool. No thread blocks in between.
+    //
+    schedule_awaiter schedule()
+    {
+        return schedule_awaiter{*this};
+    }
+#endif
+
+    //
+    // Scratch arena of the calling thread, for short lived allocations of a
+    // task. Use it with arena_allocator for std containers, say
+    //      std::vector<int, arena_allocator<int>> v{
+    //          arena_allocator<int>{thread_pool::scratch()}
+    //      };
+    // The arena is rewound after each task, so there is no contention on
+    // the heap between workers and the memory is reused while hot.
+    //
+    static monotonic_arena & scratch()
+    {
+        static thread_local monotonic_arena arena;
+        return arena;
+    }
+
+    //
+    // Snapshot of the execution metrics.
+    // enabled is false in the snapshot if THREAD_POOL_METRICS is not defined.
+    //
+    thread_pool_metrics metrics()
+    {
+        thread_pool_metrics m;
+#ifdef THREAD_POOL_METRICS
+        m.enabled = true;
+        for(size_t i=0; i<num_threads_; ++i)
+        {
+            m.workers.push_back(counters_[i].snapshot());
+            m.total += m.workers.back();
+        }
+#endif
+        m.queue_size = q_.size();
+        return m;
+    }
+
     void join()
     {
         for(size_t i=0; i<threads_.size(); ++i)
@@ -98,25 +197,95 @@ public:
     thread_pool & operator=(const thread_pool &) = delete;
     thread_pool & operator=(thread_pool &&) = delete;
 
+private:    // private types
+
+    using clock = std::chrono::steady_clock;
+
+#ifdef THREAD_POOL_METRICS
+    // queued task stamped with the time it was queued.
+    struct task_type
+    {
+        task_type() = default;
+
+        template <
+            class Fn,
+            class = typename std::enable_if<
+                !std::is_same<typename std::decay<Fn>::type, task_type>::value
+            >::type
+        >
+        task_type(Fn && fn) :
+            fn_(std::forward<Fn>(fn)), queued_(clock::now())
+        {
+        }
+
+        void operator()() { fn_(); }
+
+        const std::type_info & target_type() const
+        {
+            return fn_.target_type();
+        }
+
+        std::function<void()> fn_;
+        clock::time_point queued_;
+    };
+#else
+    using task_type = std::function<void()>;
+#endif
+
 private:    // private member functions
 
-    void thread_func()
+    void thread_func(size_t index)
     {
+#ifdef THREAD_POOL_METRICS
+        auto & counters = counters_[index];
+        auto idle_start = clock::now();
+#else
+        (void)index;
+#endif
         while (! quit_)
         {
             auto f = q_.pop();
-            try
-            {
-                f();
-            }
-            catch(...)
-            {
-                std::cout   << "\n Non standard exception in "
-                            << f.target_type().name() << "\n";
-            }
+#ifdef THREAD_POOL_METRICS
+            auto busy_start = clock::now();
+            run_task(f, counters);
+            auto busy_end = clock::now();
+            counters.record_busy_idle(
+                busy_end - busy_start, busy_start - idle_start
+            );
+            idle_start = busy_end;
+#else
+            run_task(f);
+#endif
         }
     }
 
+    static void run_task(task_type & f)
+    {
+        // a mark rather than a reset, so scratch memory taken outside a task
+        // outlives it.
+        auto & arena = scratch();
+        auto mark = arena.mark();
+        try
+        {
+            f();
+        }
+        catch(...)
+        {
+            std::cout   << "\n Non standard exception in "
+                        << f.target_type().name() << "\n";
+        }
+        arena.rewind(mark);
+    }
+
+#ifdef THREAD_POOL_METRICS
+    static void run_task(task_type & f, detail::worker_counters & counters)
+    {
+        auto start = clock::now();
+        run_task(f);
+        counters.record_task(start - f.queued_, clock::now() - start);
+    }
+#endif
+
     template <class Fn>
     static typename std::enable_if<
         !std::is_void<typename std::result_of<Fn()>::type>::value ,void
@@ -151,11 +320,19 @@ private:    // private data members
     // threads in the pool
     std::vector<std::thread> threads_;
 
+    // number of threads started, even after join.
+    size_t num_threads_;
+
     // the task queue
-    queue_mt<std::function<void()>> q_;
+    queue_mt<task_type> q_;
 
     // quit signal
     std::atomic<bool> quit_;
+
+#ifdef THREAD_POOL_METRICS
+    // one per worker.
+    std::unique_ptr<detail::worker_counters[]> counters_;
+#endif
 };
 
 } // namespace utils
@@ -0,0 +1,216 @@
+//----------------------------------------------------------------------------
+// year   : 2026
+// author : John Paul
+// email  : johnpaultaken@gmail.com
+// source : https://github.com/johnpaultaken
+// description :
+//      Execution metrics for thread_pool in C++11.
+//      Tasks executed, busy and idle time, and histograms of queue wait and
+//      run time latency, per worker and for the whole pool.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace utils
+{
+
+/*
+Notes:
+1.  Metrics are collected only if THREAD_POOL_METRICS is defined before
+    including thread_pool.h. Otherwise the collection code is compiled out
+    and thread_pool::metrics() returns a snapshot with enabled == false.
+2.  Latency histograms have power of 2 nanosecond buckets, so percentiles
+    are accurate to within a factor of 2. That is enough to tell a pool
+    that is undersized (queue wait grows) from one with slow tasks (run
+    time grows).
+3.  Counters of a worker are written by that worker only, with relaxed
+    atomics. A snapshot is therefore not an atomic view across counters.
+*/
+
+//
+// Snapshot of a latency histogram.
+// Bucket i counts latencies in [2^i, 2^(i+1)) nanoseconds, bucket 0 also
+// counts 0.
+//
+struct latency_histogram
+{
+    static const size_t num_buckets = 48;
+
+    uint64_t buckets[num_buckets] = {};
+
+    uint64_t count() const
+    {
+        uint64_t n = 0;
+        for (auto b : buckets)
+        {
+            n += b;
+        }
+        return n;
+    }
+
+    //
+    // Param: p - percentile in [0, 1], say 0.99 for p99.
+    // Return: upper bound in nanoseconds of the bucket holding p.
+    //
+    uint64_t percentile(double p) const
+    {
+        auto total = count();
+        if (total == 0)
+        {
+            return 0;
+        }
+        auto rank = uint64_t(p * double(total - 1)) + 1;
+        uint64_t n = 0;
+        for (size_t i=0; i<num_buckets; ++i)
+        {
+            n += buckets[i];
+            if (n >= rank)
+            {
+                return (uint64_t{2} << i) - 1;
+            }
+        }
+        return ~uint64_t{0};
+    }
+
+    latency_histogram & operator += (const latency_histogram & other)
+    {
+        for (size_t i=0; i<num_buckets; ++i)
+        {
+            buckets[i] += other.buckets[i];
+        }
+        return *this;
+    }
+};
+
+//
+// Snapshot of the metrics of one worker, or the sum over workers.
+//
+struct worker_metrics
+{
+    uint64_t tasks_executed = 0;
+    std::chrono::nanoseconds busy_time{0};
+    std::chrono::nanoseconds idle_time{0};
+    latency_histogram queue_wait;
+    latency_histogram run_time;
+
+    // fraction of time spent running tasks.
+    double utilization() const
+    {
+        auto total = busy_time + idle_time;
+        return total.count() ? double(busy_time.count()) / total.count() : 0.0;
+    }
+
+    worker_metrics & operator += (const worker_metrics & other)
+    {
+        tasks_executed += other.tasks_executed;
+        busy_time += other.busy_time;
+        idle_time += other.idle_time;
+        queue_wait += other.queue_wait;
+        run_time += other.run_time;
+        return *this;
+    }
+};
+
+//
+// Snapshot returned by thread_pool::metrics().
+//
+struct thread_pool_metrics
+{
+    bool enabled = false;
+
+    // one per worker thread.
+    std::vector<worker_metrics> workers;
+
+    // sum over the workers.
+    worker_metrics total;
+
+    // tasks queued and not yet started at the time of the snapshot.
+    size_t queue_size = 0;
+};
+
+namespace detail
+{
+
+//
+// Live counters of one worker.
+//
+struct worker_counters
+{
+    using clock = std::chrono::steady_clock;
+
+    std::atomic<uint64_t> tasks_executed{0};
+    std::atomic<uint64_t> busy_ns{0};
+    std::atomic<uint64_t> idle_ns{0};
+    std::atomic<uint64_t> queue_wait[latency_histogram::num_buckets] = {};
+    std::atomic<uint64_t> run_time[latency_histogram::num_buckets] = {};
+
+    // only the worker writes, so no need for a locked read-modify-write.
+    static void add(std::atomic<uint64_t> & counter, uint64_t n)
+    {
+        counter.store(
+            counter.load(std::memory_order_relaxed) + n,
+            std::memory_order_relaxed
+        );
+    }
+
+    static size_t bucket(clock::duration d)
+    {
+        auto ns = uint64_t(
+            std::max<int64_t>(
+                0,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()
+            )
+        );
+        size_t i = 0;
+        while (ns >>= 1)
+        {
+            ++i;
+        }
+        return std::min(i, latency_histogram::num_buckets - 1);
+    }
+
+    void record_task(clock::duration wait, clock::duration run)
+    {
+        add(tasks_executed, 1);
+        add(queue_wait[bucket(wait)], 1);
+        add(run_time[bucket(run)], 1);
+    }
+
+    void record_busy_idle(clock::duration busy, clock::duration idle)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::nanoseconds;
+        add(busy_ns, uint64_t(duration_cast<nanoseconds>(busy).count()));
+        add(idle_ns, uint64_t(duration_cast<nanoseconds>(idle).count()));
+    }
+
+    worker_metrics snapshot() const
+    {
+        worker_metrics m;
+        m.tasks_executed = tasks_executed.load(std::memory_order_relaxed);
+        m.busy_time = std::chrono::nanoseconds(
+            busy_ns.load(std::memory_order_relaxed)
+        );
+        m.idle_time = std::chrono::nanoseconds(
+            idle_ns.load(std::memory_order_relaxed)
+        );
+        for (size_t i=0; i<latency_histogram::num_buckets; ++i)
+        {
+            m.queue_wait.buckets[i] =
+                queue_wait[i].load(std::memory_order_relaxed);
+            m.run_time.buckets[i] =
+                run_time[i].load(std::memory_order_relaxed);
+        }
+        return m;
+    }
+};
+
+} // namespace detail
+
+} // namespace utils